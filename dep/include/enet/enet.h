@@ -11,6 +11,7 @@ extern "C"
 #endif
 
 #include <stdlib.h>
+#include <stddef.h>
 
 #if defined(WIN32) || defined(_WIN32)
 #include "enet/win32.h"
@@ -231,6 +232,8 @@ typedef struct _ENetChannel
 typedef struct _ENetPeer
 { 
    ENetListNode  dispatchList;
+   ENetListNode  activeList;         /**< Node in the host's active peers, or in its free peers once disconnected */
+   int           isActive;
    struct _ENetHost * host;
    enet_uint16   outgoingPeerID;
    enet_uint16   incomingPeerID;
@@ -314,6 +317,9 @@ typedef struct _ENetHost
    int                  recalculateBandwidthLimits;
    ENetPeer *           peers;                       /**< array of peers allocated for this host */
    size_t               peerCount;                   /**< number of peers allocated for this host */
+   size_t               initializedPeers;            /**< peers [0, initializedPeers) were set up, the rest is untouched memory */
+   ENetList             activePeers;                 /**< peers that aren't disconnected, the only ones the protocol walks */
+   ENetList             freePeers;                   /**< set up peers that are disconnected, reused first */
    size_t               channelLimit;                /**< maximum number of channels allowed for connected peers */
    enet_uint32          serviceTime;
    ENetList             dispatchQueue;
@@ -486,6 +492,10 @@ ENET_API void       enet_host_broadcast (ENetHost *, enet_uint8, ENetPacket *);
 ENET_API void       enet_host_channel_limit (ENetHost *, size_t);
 ENET_API void       enet_host_bandwidth_limit (ENetHost *, enet_uint32, enet_uint32);
 extern   void       enet_host_bandwidth_throttle (ENetHost *);
+extern   ENetPeer * enet_host_acquire_peer (ENetHost *);
+
+/** Peer of a node of ENetHost::activePeers */
+#define enet_host_active_peer(iterator) ((ENetPeer *) ((char *) (iterator) - offsetof (ENetPeer, activeList)))
 
 ENET_API int                 enet_peer_send (ENetPeer *, enet_uint8, ENetPacket *);
 ENET_API ENetPacket *        enet_peer_receive (ENetPeer *, enet_uint8 * channelID);
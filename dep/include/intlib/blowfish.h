@@ -123,6 +123,9 @@ E73214A2822139CA62B343CC5B65587310DD908D0C241B2263C2CF80DA
 #ifndef __BLOWFISH_H__
 #define __BLOWFISH_H__
 
+#include <memory>
+#include <stddef.h>
+
 typedef unsigned int uint32;
 typedef unsigned long long int uint64;
 #define LODWORD(l) ((uint32)((uint64)(l)))
@@ -143,13 +146,28 @@ struct SBlock
 	unsigned int m_uil, m_uir;
 };
 
+//P and S boxes of a key, shared read-only by every context using that key
+struct BlowFishSchedule
+{
+	unsigned int P[18];
+	unsigned int S[4][256];
+};
+
+//Schedules kept alive by the cache even when no context uses them anymore
+#define BLOWFISH_CACHE_SIZE 64
+
 class BlowFish
 {
 public:
 	enum { ECB=0, CBC=1, CFB=2 };
 
 	//Constructor - Initialize the P and S boxes for a given Key
+	//The schedule comes from the cache, only a new key costs the 521 block encryptions
 	BlowFish(unsigned char* ucKey, size_t n, const SBlock& roChain = SBlock(0UL,0UL));
+	~BlowFish();
+
+	//Key schedule of a key, computed once and shared. Thread safe.
+	static std::shared_ptr<const BlowFishSchedule> getSchedule(const unsigned char* ucKey, size_t n);
 
 	//Resetting the chaining block
 	void ResetChain() { m_oChain = m_oChain0; }
@@ -167,20 +185,28 @@ public:
 	void Decrypt(const unsigned char* in, unsigned char* out, size_t n, int iMode=ECB);
 
 	unsigned char *getKey();
+	size_t getKeySize() const { return _keySize; }
 
 //Private Functions
 private:
 	unsigned int F(unsigned int ui);
 	void Encrypt(SBlock&);
 	void Decrypt(SBlock&);
+	void ComputeSchedule(BlowFishSchedule* schedule, const unsigned char* ucKey, size_t keysize);
+
+	BlowFish() : _keyCopy(0), _keySize(0) {} //Only to compute schedules
+	BlowFish(const BlowFish&);
+	BlowFish& operator=(const BlowFish&);
 
 private:
 	//The Initialization Vector, by default {0, 0}
 	unsigned char *_keyCopy;
+	size_t _keySize;
 	SBlock m_oChain0;
 	SBlock m_oChain;
-	unsigned int m_auiP[18];
-	unsigned int m_auiS[4][256];
+	std::shared_ptr<const BlowFishSchedule> m_schedule;
+	const unsigned int *m_auiP;
+	const unsigned int (*m_auiS)[256];
 	static const unsigned int scm_auiInitP[18];
 	static const unsigned int scm_auiInitS[4][256];
 };
@@ -14,6 +14,7 @@
 
     @param address   the address at which other peers may connect to this host.  If NULL, then no peers may connect to the host.
     @param peerCount the maximum number of peers that should be allocated for the host.
+    Peers are only set up when first used, so a large count costs nothing until peers connect.
     @param incomingBandwidth downstream bandwidth of the host in bytes/second; if 0, ENet will assume unlimited bandwidth.
     @param outgoingBandwidth upstream bandwidth of the host in bytes/second; if 0, ENet will assume unlimited bandwidth.
 
@@ -28,7 +29,6 @@ ENetHost *
 enet_host_create (const ENetAddress * address, size_t peerCount, enet_uint32 incomingBandwidth, enet_uint32 outgoingBandwidth)
 {
     ENetHost * host;
-    ENetPeer * currentPeer;
 
     if (peerCount > ENET_PROTOCOL_MAXIMUM_PEER_ID)
       return NULL;
@@ -45,8 +45,6 @@ enet_host_create (const ENetAddress * address, size_t peerCount, enet_uint32 inc
        return NULL;
     }
 
-    memset (host -> peers, 0, peerCount * sizeof (ENetPeer));
-
     host -> socket = enet_socket_create (ENET_SOCKET_TYPE_DATAGRAM);
     if (host -> socket == ENET_SOCKET_NULL || (address != NULL && enet_socket_bind (host -> socket, address) < 0))
     {
@@ -74,6 +72,7 @@ enet_host_create (const ENetAddress * address, size_t peerCount, enet_uint32 inc
     host -> recalculateBandwidthLimits = 0;
     host -> mtu = ENET_HOST_DEFAULT_MTU;
     host -> peerCount = peerCount;
+    host -> initializedPeers = 0;
     host -> commandCount = 0;
     host -> bufferCount = 0;
 //    host -> checksum = NULL;
@@ -87,26 +86,54 @@ enet_host_create (const ENetAddress * address, size_t peerCount, enet_uint32 inc
     host -> totalReceivedPackets = 0;
 
     enet_list_clear (& host -> dispatchQueue);
+    enet_list_clear (& host -> activePeers);
+    enet_list_clear (& host -> freePeers);
+ 
+    return host;
+}
+
+/** Takes a disconnected peer for a new connection and makes it active.
+    Peers that were used before are reused first, then the next untouched
+    peer of the array is set up.
+    @param host host to take the peer from
+    @returns the peer, still disconnected, or NULL if the host is full
+*/
+ENetPeer *
+enet_host_acquire_peer (ENetHost * host)
+{
+    ENetPeer * peer;
 
-    for (currentPeer = host -> peers;
-         currentPeer < & host -> peers [host -> peerCount];
-         ++ currentPeer)
+    if (! enet_list_empty (& host -> freePeers))
+    {
+       peer = enet_host_active_peer (enet_list_begin (& host -> freePeers));
+       enet_list_remove (& peer -> activeList);
+    }
+    else
+    if (host -> initializedPeers < host -> peerCount)
     {
-       currentPeer -> host = host;
-       currentPeer -> incomingPeerID = currentPeer - host -> peers;
-       currentPeer -> data = NULL;
+       peer = & host -> peers [host -> initializedPeers ++];
+       memset (peer, 0, sizeof (ENetPeer));
 
-       enet_list_clear (& currentPeer -> acknowledgements);
-       enet_list_clear (& currentPeer -> sentReliableCommands);
-       enet_list_clear (& currentPeer -> sentUnreliableCommands);
-       enet_list_clear (& currentPeer -> outgoingReliableCommands);
-       enet_list_clear (& currentPeer -> outgoingUnreliableCommands);
-       enet_list_clear (& currentPeer -> dispatchedCommands);
+       peer -> host = host;
+       peer -> incomingPeerID = peer - host -> peers;
+       peer -> data = NULL;
 
-       enet_peer_reset (currentPeer);
+       enet_list_clear (& peer -> acknowledgements);
+       enet_list_clear (& peer -> sentReliableCommands);
+       enet_list_clear (& peer -> sentUnreliableCommands);
+       enet_list_clear (& peer -> outgoingReliableCommands);
+       enet_list_clear (& peer -> outgoingUnreliableCommands);
+       enet_list_clear (& peer -> dispatchedCommands);
+
+       enet_peer_reset (peer);
     }
- 
-    return host;
+    else
+      return NULL;
+
+    enet_list_insert (enet_list_end (& host -> activePeers), & peer -> activeList);
+    peer -> isActive = 1;
+
+    return peer;
 }
 
 /** Destroys the host and all resources associated with it.
@@ -119,10 +146,9 @@ enet_host_destroy (ENetHost * host)
 
     enet_socket_destroy (host -> socket);
 
-    for (currentPeer = host -> peers;
-         currentPeer < & host -> peers [host -> peerCount];
-         ++ currentPeer)
+    while (! enet_list_empty (& host -> activePeers))
     {
+       currentPeer = enet_host_active_peer (enet_list_begin (& host -> activePeers));
        enet_peer_reset (currentPeer);
     }
 
@@ -151,20 +177,17 @@ enet_host_connect (ENetHost * host, const ENetAddress * address, size_t channelC
     if (channelCount > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT)
       channelCount = ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT;
 
-    for (currentPeer = host -> peers;
-         currentPeer < & host -> peers [host -> peerCount];
-         ++ currentPeer)
-    {
-       if (currentPeer -> state == ENET_PEER_STATE_DISCONNECTED)
-         break;
-    }
-
-    if (currentPeer >= & host -> peers [host -> peerCount])
+    currentPeer = enet_host_acquire_peer (host);
+    if (currentPeer == NULL)
       return NULL;
 
     currentPeer -> channels = (ENetChannel *) enet_malloc (channelCount * sizeof (ENetChannel));
     if (currentPeer -> channels == NULL)
-      return NULL;
+    {
+       enet_peer_reset (currentPeer);
+
+       return NULL;
+    }
     currentPeer -> channelCount = channelCount;
     currentPeer -> state = ENET_PEER_STATE_CONNECTING;
     currentPeer -> address = * address;
@@ -241,12 +264,14 @@ enet_host_channel_limit (ENetHost * host, size_t channelLimit)
 void
 enet_host_broadcast (ENetHost * host, enet_uint8 channelID, ENetPacket * packet)
 {
-    ENetPeer * currentPeer;
+    ENetListIterator currentNode;
 
-    for (currentPeer = host -> peers;
-         currentPeer < & host -> peers [host -> peerCount];
-         ++ currentPeer)
+    for (currentNode = enet_list_begin (& host -> activePeers);
+         currentNode != enet_list_end (& host -> activePeers);
+         currentNode = enet_list_next (currentNode))
     {
+       ENetPeer * currentPeer = enet_host_active_peer (currentNode);
+
        if (currentPeer -> state != ENET_PEER_STATE_CONNECTED)
          continue;
 
@@ -324,6 +324,13 @@ enet_peer_reset_queues (ENetPeer * peer)
 void
 enet_peer_reset (ENetPeer * peer)
 {
+    if (peer -> isActive)
+    {
+       enet_list_remove (& peer -> activeList);
+       enet_list_insert (enet_list_end (& peer -> host -> freePeers), & peer -> activeList);
+       peer -> isActive = 0;
+    }
+
     peer -> outgoingPeerID = ENET_PROTOCOL_MAXIMUM_PEER_ID;
     peer -> sessionID = 0;
 
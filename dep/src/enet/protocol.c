@@ -247,6 +247,7 @@ enet_protocol_handle_connect (ENetHost * host, ENetProtocolHeader * header, ENet
     ENetChannel * channel;
     enet_uint32 channelCount;
     ENetPeer * currentPeer;
+    ENetListIterator currentNode;
     ENetProtocol verifyCommand;
 
     /*if (host -> checksum != NULL)
@@ -274,10 +275,12 @@ enet_protocol_handle_connect (ENetHost * host, ENetProtocolHeader * header, ENet
         channelCount > ENET_PROTOCOL_MAXIMUM_CHANNEL_COUNT)
       return NULL;
 
-    for (currentPeer = host -> peers;
-         currentPeer < & host -> peers [host -> peerCount];
-         ++ currentPeer)
+    for (currentNode = enet_list_begin (& host -> activePeers);
+         currentNode != enet_list_end (& host -> activePeers);
+         currentNode = enet_list_next (currentNode))
     {
+        currentPeer = enet_host_active_peer (currentNode);
+
         if (currentPeer -> state != ENET_PEER_STATE_DISCONNECTED &&
             currentPeer -> address.host == host -> receivedAddress.host &&
             currentPeer -> address.port == host -> receivedAddress.port &&
@@ -285,24 +288,19 @@ enet_protocol_handle_connect (ENetHost * host, ENetProtocolHeader * header, ENet
           return NULL;
     }
 
-    for (currentPeer = host -> peers;
-         currentPeer < & host -> peers [host -> peerCount];
-         ++ currentPeer)
-    {
-        if (currentPeer -> state == ENET_PEER_STATE_DISCONNECTED)
-          break;
-    }
-    
-    
-
-    if (currentPeer >= & host -> peers [host -> peerCount])
+    currentPeer = enet_host_acquire_peer (host);
+    if (currentPeer == NULL)
       return NULL;
 
     if (channelCount > host -> channelLimit)
       channelCount = host -> channelLimit;
     currentPeer -> channels = (ENetChannel *) enet_malloc (channelCount * sizeof (ENetChannel));
     if (currentPeer -> channels == NULL)
-      return NULL;
+    {
+       enet_peer_reset (currentPeer);
+
+       return NULL;
+    }
       
     currentPeer -> channelCount = channelCount;
     currentPeer -> state = ENET_PEER_STATE_ACKNOWLEDGING_CONNECT;
@@ -833,7 +831,7 @@ enet_protocol_handle_incoming_commands (ENetHost * host, ENetEvent * event)
     if (peerID == ENET_PROTOCOL_MAXIMUM_PEER_ID)
       peer = NULL;
     else
-    if (peerID >= host -> peerCount)
+    if (peerID >= host -> initializedPeers)
       return 0;
     else
     {
@@ -1340,16 +1338,21 @@ enet_protocol_send_outgoing_commands (ENetHost * host, ENetEvent * event, int ch
 {
     ENetProtocolHeader header;
     ENetPeer * currentPeer;
+    ENetListIterator currentNode, nextNode;
     int sentLength;
     
     host -> continueSending = 1;
 
+    /* Peers may be reset while they're processed, which moves them to the free list */
     while (host -> continueSending)
     for (host -> continueSending = 0,
-           currentPeer = host -> peers;
-         currentPeer < & host -> peers [host -> peerCount];
-         ++ currentPeer)
+           currentNode = enet_list_begin (& host -> activePeers);
+         currentNode != enet_list_end (& host -> activePeers);
+         currentNode = nextNode)
     {
+        currentPeer = enet_host_active_peer (currentNode);
+        nextNode = enet_list_next (currentNode);
+
         if (currentPeer -> state == ENET_PEER_STATE_DISCONNECTED ||
             currentPeer -> state == ENET_PEER_STATE_ZOMBIE)
           continue;
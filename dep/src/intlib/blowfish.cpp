@@ -1,4 +1,7 @@
 #include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
 #include <blowfish.h>
 
 uint64 ntohll(uint64 a)
@@ -302,18 +305,74 @@ BlowFish::BlowFish(unsigned char* ucKey, size_t keysize, const SBlock& roChain)
 	//Check the Key - the key length should be between 1 and 56 bytes
 	if(keysize>56)
 		keysize = 56;
-	unsigned char aucLocalKey[56];
-	unsigned int i, j;
 
 	//Save a copy of the used key
 	_keyCopy = new unsigned char[keysize];
+	_keySize = keysize;
 	memcpy(_keyCopy, ucKey, keysize);
 
+	m_schedule = getSchedule(ucKey, keysize);
+	m_auiP = m_schedule->P;
+	m_auiS = m_schedule->S;
+}
+
+BlowFish::~BlowFish()
+{
+	delete[] _keyCopy;
+}
+
+std::shared_ptr<const BlowFishSchedule> BlowFish::getSchedule(const unsigned char* ucKey, size_t keysize)
+{
+	static std::mutex cacheLock;
+	static std::map<std::string, std::shared_ptr<const BlowFishSchedule> > cache;
+
+	if(keysize>56)
+		keysize = 56;
+	std::string key((const char*)ucKey, keysize);
+
+	{
+		std::lock_guard<std::mutex> guard(cacheLock);
+		std::map<std::string, std::shared_ptr<const BlowFishSchedule> >::iterator it = cache.find(key);
+		if(it != cache.end())
+			return it->second;
+	}
+
+	//Computed outside the lock, two threads may both compute a new key but they get the same tables
+	BlowFishSchedule* schedule = new BlowFishSchedule;
+	BlowFish builder;
+	builder.ComputeSchedule(schedule, ucKey, keysize);
+	std::shared_ptr<const BlowFishSchedule> shared(schedule);
+
+	std::lock_guard<std::mutex> guard(cacheLock);
+	if(cache.size() >= BLOWFISH_CACHE_SIZE)
+	{
+		//Forget the schedules no context uses anymore
+		for(std::map<std::string, std::shared_ptr<const BlowFishSchedule> >::iterator it = cache.begin(); it != cache.end(); )
+		{
+			if(it->second.use_count() == 1)
+				cache.erase(it++);
+			else
+				++it;
+		}
+	}
+	std::pair<std::map<std::string, std::shared_ptr<const BlowFishSchedule> >::iterator, bool> inserted = cache.insert(std::make_pair(key, shared));
+	return inserted.first->second;
+}
+
+//Key expansion, the boxes being filled are the ones the rounds read from
+void BlowFish::ComputeSchedule(BlowFishSchedule* schedule, const unsigned char* ucKey, size_t keysize)
+{
+	unsigned char aucLocalKey[56];
+	unsigned int i, j;
+
+	m_auiP = schedule->P;
+	m_auiS = schedule->S;
+
 	memcpy(aucLocalKey, ucKey, keysize);
 	//Reflexive Initialization of the Blowfish.
 	//Generating the Subkeys from the Key flood P and S boxes with PI
-	memcpy(m_auiP, scm_auiInitP, sizeof m_auiP);
-	memcpy(m_auiS, scm_auiInitS, sizeof m_auiS);
+	memcpy(schedule->P, scm_auiInitP, sizeof schedule->P);
+	memcpy(schedule->S, scm_auiInitS, sizeof schedule->S);
 	//Load P boxes with key bytes
 	const unsigned char* p = aucLocalKey;
 	unsigned int x=0;
@@ -324,7 +383,6 @@ BlowFish::BlowFish(unsigned char* ucKey, size_t keysize, const SBlock& roChain)
 		x=0;
 		for(int n=4; n--; )
 		{
-			int iVal = (int)(*p);
 			x <<= 8;
 			x |= *(p++);
 			iCount++;
@@ -335,15 +393,15 @@ BlowFish::BlowFish(unsigned char* ucKey, size_t keysize, const SBlock& roChain)
 				p = aucLocalKey;
 			}
 		}
-		m_auiP[i] ^= x;
+		schedule->P[i] ^= x;
 	}
 	//Reflect P and S boxes through the evolving Blowfish
 	SBlock block(0UL,0UL); //all-zero block
 	for(i=0; i<18; )
-		Encrypt(block), m_auiP[i++] = block.m_uil, m_auiP[i++] = block.m_uir;
+		Encrypt(block), schedule->P[i++] = block.m_uil, schedule->P[i++] = block.m_uir;
 	for(j=0; j<4; j++)
 		for(int k=0; k<256; )
-			Encrypt(block), m_auiS[j][k++] = block.m_uil, m_auiS[j][k++] = block.m_uir;
+			Encrypt(block), schedule->S[j][k++] = block.m_uil, schedule->S[j][k++] = block.m_uir;
 }
 
 uint64 BlowFish::Encrypt(uint64 buf)
@@ -10,10 +10,13 @@ protected:
    
 public:
    AI(Unit* me) : me(me) { }
+   virtual ~AI() { }
    
    virtual void onSpawn() = 0;
    virtual void onDamageTaken(Unit* source, float amount) = 0;
-   virtual void update(unsigned int diff) { }
+   virtual void update(unsigned int) { }
+   virtual void save(SnapshotWriter&) const { }
+   virtual void load(SnapshotReader&) { }
 
 };
 
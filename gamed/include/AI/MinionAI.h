@@ -2,15 +2,59 @@
 #define _MINION_AI_H
 
 #include "AI.h"
+#include "Targeting.h"
+#include "TimerWheel.h"
+
+#define AI_FULL_RATE 250          // Think interval near champions, in milliseconds
+#define AI_COARSE_RATE 1000       // Think interval everywhere else
+#define AI_LOD_RANGE 2000.f       // Distance to a champion under which minions think at full rate
+#define AI_ACQUISITION_RANGE 700.f
+#define AI_LEASH_RANGE 1000.f     // Targets further than this are dropped
+
+enum MinionLane : uint8 {
+   LANE_TOP,
+   LANE_MID,
+   LANE_BOT
+};
+
+enum MinionAIState : uint8 {
+   MINION_WALKING,
+   MINION_CHASING,
+   MINION_IN_RANGE
+};
+
+/**
+ * Follows the minion's lane, and chases enemies that come in range.
+ * The AI only thinks on timer events, at a rate depending on how close the
+ * nearest champion is, so far away waves cost almost nothing.
+ * New targets are looked up through the map's batched targeting queries.
+ */
+class MinionAI : public AI, public Timer, public TargetListener {
+
+private:
+   uint32 targetId;
+   MovementVector chasePoint; // Where the target was when we last chased it
+   MinionLane lane;
+   MinionAIState state;
+
+   void think();
+   void walkLane();
+   void moveTo(float x, float y);
+   void engage(Unit* target);
+   bool isNearChampion();
+
+protected:
+   void onTimer() { think(); }
 
-class MinionAI : public AI {
-   
 public:
-   MinionAI(Unit* me) : AI(me) { }
-   void update(unsigned int diff) { }
-   void onSpawn() { }
-   void onDamageTaken(Unit* source, float amount) { }
+   MinionAI(Unit* me) : AI(me), targetId(0), lane(LANE_MID), state(MINION_WALKING) { }
+   ~MinionAI();
+   void onSpawn();
+   void onDamageTaken(Unit* source, float amount);
+   void onTargetsFound(Unit** targets, uint32 count);
+   void save(SnapshotWriter& s) const;
+   void load(SnapshotReader& s);
 
 };
 
-#endif
\ No newline at end of file
+#endif
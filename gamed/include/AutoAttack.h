@@ -0,0 +1,79 @@
+#ifndef _AUTO_ATTACK_H
+#define _AUTO_ATTACK_H
+
+#include "stdafx.h"
+#include "TimerWheel.h"
+
+#define ATTACK_BASE_SPEED 0.625f   // Attacks per second before bonuses
+#define ATTACK_WINDUP_RATIO 0.3f   // Part of the attack interval spent winding up
+#define ATTACK_RANGE_SLACK 50.f    // Extra range the target may walk off during the windup
+#define ATTACK_RETRY_DELAY 100     // Milliseconds before retrying when the target is out of range
+#define ATTACK_MELEE_RANGE 300.f   // Attackers with less range hit instantly, without a missile
+#define ATTACK_MISSILE_SPEED 1200.f
+
+class SnapshotReader;
+class SnapshotWriter;
+class Unit;
+
+enum AttackState : uint8 {
+   ATTACK_IDLE,
+   ATTACK_WINDUP,
+   ATTACK_COOLDOWN
+};
+
+/**
+ * Attack fired during a tick, sent to the clients all at once by the map
+ */
+struct AttackEvent {
+   uint32 sourceId;
+   uint32 targetId;
+   float x, y;
+};
+
+/**
+ * Basic attack state machine of a unit: wind up, fire, then wait for the
+ * rest of the attack interval before winding up again.
+ * Ranged attackers fire a missile from the map's pool, damage is dealt when
+ * it lands. The whole cycle runs on the timer wheel and never allocates.
+ */
+class AutoAttack : public Timer {
+
+private:
+   Unit* owner;
+   uint32 targetId;
+   float baseSpeed;
+   float missileSpeed;
+   AttackState state;
+
+   Unit* getTargetUnit() const;
+   bool isInRange(Unit* target) const;
+   void fire(Unit* target);
+
+protected:
+   void onTimer();
+
+public:
+   AutoAttack(Unit* owner) : owner(owner), targetId(0), baseSpeed(ATTACK_BASE_SPEED), missileSpeed(ATTACK_MISSILE_SPEED), state(ATTACK_IDLE) { }
+
+   /**
+    * Starts attacking target, an attack already winding up isn't reset
+    */
+   void start(Unit* target);
+   void stop();
+
+   /**
+    * @return the milliseconds between two attacks, from the attack speed
+    */
+   uint32 getInterval() const;
+
+   uint32 getTargetId() const { return targetId; }
+   AttackState getState() const { return state; }
+   void setBaseSpeed(float speed) { baseSpeed = speed; }
+   void setMissileSpeed(float speed) { missileSpeed = speed; }
+
+   void save(SnapshotWriter& s) const;
+   void load(SnapshotReader& s);
+
+};
+
+#endif
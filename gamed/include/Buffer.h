@@ -3,13 +3,18 @@
 
 #include <vector>
 
+#include "PacketPool.h"
+
+/* Packets are built on the network thread, their bytes come from the packet pool */
+typedef std::vector<uint8, PoolAllocator<uint8> > PacketBytes;
+
 class Buffer {
 
 private:
-   std::vector<uint8> buffer;
+   PacketBytes buffer;
 
 public:
-   const std::vector<uint8>& getBytes() const { return buffer; }
+   const PacketBytes& getBytes() const { return buffer; }
    void clear() { buffer.clear(); }
    
    Buffer& operator<<(const std::string& data)
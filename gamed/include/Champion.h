@@ -13,17 +13,24 @@ protected:
    uint8 skillPoints;
    uint8 level;
    float xp;
+   uint32 viewDelay; // Milliseconds between the game and what the player sees of it
    
 public:
    Champion(const std::string& type, Map* map, uint32 id);
    const std::string& getType() { return type; }
+   UnitKind getKind() const { return UNIT_CHAMPION; }
+   void onKill(Unit* victim);
    
    Spell* castSpell(uint8 slot, float x, float y, Unit* target);
    Spell* levelUpSpell(uint8 slot);
    
-   virtual void update(unsigned int diff);
-   
    uint8 getSkillPoints() const { return skillPoints; }
+   
+   uint32 getViewDelay() const { return viewDelay; }
+   void setViewDelay(uint32 delay) { viewDelay = delay; }
+   
+   void save(SnapshotWriter& s) const;
+   void load(SnapshotReader& s);
 
 };
 
@@ -1,24 +1,21 @@
 #ifndef _CHAMPION_FACTORY_H
 #define _CHAMPION_FACTORY_H
 
-#include "Champions/Ezreal/Ezreal.h"
+#include "Champion.h"
 
 class ChampionFactory {
 
 public:
 
    /**
-    * Todo : Code every champion and add em here..
+    * Champions only need a class here when they script more than their
+    * spells, their stats and spells come from the game data.
     */
    static Champion* getChampionFromType(const std::string& type, Map* map, uint32 id) {
-      if(type == "Ezreal") {
-         return new Ezreal(map, id);
-      }
-      
       return new Champion(type, map, id);
    }
 
 
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -3,31 +3,14 @@
 
 #include "Spell.h"
 
-#define ID_MYSTICSHOT 0x017f4044
-
 class MysticShot : public Spell {
 private:
    float damage[5];
+   float projectileSpeed;
    
 public:
-   MysticShot(Champion* owner) : Spell(ID_MYSTICSHOT, owner, 0.25f, 0) {
-      cooldown[0] = 6;
-      cooldown[1] = 5.5f;
-      cooldown[2] = 5;
-      cooldown[3] = 4.5f;
-      cooldown[4] = 4;
-      
-      cost[0] = 28;
-      cost[1] = 31;
-      cost[2] = 34;
-      cost[3] = 37;
-      cost[4] = 40;
-      
-      damage[0] = 35;
-      damage[0] = 55;
-      damage[0] = 75;
-      damage[0] = 95;
-      damage[0] = 115;
+   MysticShot(Champion* owner, uint8 slot, const SpellData* data) : Spell(owner, slot, data), projectileSpeed(data->projectileSpeed) {
+      memcpy(damage, data->damage, sizeof(damage));
    }
    
    /**
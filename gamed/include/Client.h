@@ -20,6 +20,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "common.h"
 #include "ChampionFactory.h"
+#include "ReplicatedState.h"
+#include "SendQueue.h"
+#include <intlib/blowfish.h>
 #include <string>
 
 struct ClientInfo
@@ -29,10 +32,12 @@ struct ClientInfo
 		keyChecked = false;
 		ticks = 0;
 		skinNo = 0;
+		blowfish = 0;
 	}
 
 	~ClientInfo()
 	{
+		delete blowfish;
 	}
 
 	void setName(const std::string& name)
@@ -65,8 +70,11 @@ struct ClientInfo
    uint64 userId;
    uint32 ticks;
    uint32 skinNo;
+   BlowFish* blowfish; // Selected at KeyCheck, the game's key until then
    std::string name;
    Champion* champion;
+   SendQueue sendQueue;
+   ReplicatedState replicated;
 
 };
 
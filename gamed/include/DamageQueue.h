@@ -0,0 +1,57 @@
+#ifndef _DAMAGE_QUEUE_H
+#define _DAMAGE_QUEUE_H
+
+#include <vector>
+
+#include "stdafx.h"
+
+class Map;
+class Unit;
+
+enum DamageType : uint8 {
+   DAMAGE_TYPE_PHYSICAL,
+   DAMAGE_TYPE_MAGICAL
+};
+
+enum DamageSource : uint8 {
+   DAMAGE_SOURCE_ATTACK,
+   DAMAGE_SOURCE_SPELL
+};
+
+struct DamageEvent {
+   uint32 sourceId;
+   uint32 targetId;
+   float amount;      // Before mitigation
+   DamageType type;
+   DamageSource source;
+};
+
+/**
+ * Damage dealt during a tick, applied all at once at its end.
+ * Events are grouped by target, so each damaged unit has its health
+ * written and sent to the clients only once, however many hits it took.
+ */
+class DamageQueue {
+
+private:
+   Map* map;
+   std::vector<DamageEvent> events;
+
+   static float mitigate(float amount, float resistance);
+
+public:
+   DamageQueue(Map* map) : map(map) { }
+
+   void push(Unit* source, Unit* target, float amount, DamageType type, DamageSource damageSource);
+
+   /**
+    * Applies the mitigated damage, firing the death and kill hooks
+    * @param damaged receives every unit whose health changed, once each
+    */
+   void process(std::vector<Unit*>& damaged);
+
+   bool isEmpty() const { return events.empty(); }
+
+};
+
+#endif
@@ -0,0 +1,158 @@
+/**
+ * Always-on record of the last moments of the server: decrypted inbound
+ * messages, recorded before their handler runs and patched with its result
+ * once it returns, outbound messages before their
+ * encryption, connections and tick durations.
+ * Events go in a fixed ring of slots, the oldest ones being overwritten. A
+ * writer claims a slot with one atomic increment and publishes it with its
+ * sequence number, so recording never locks nor allocates, and a dump can
+ * read the ring from a signal handler while the server still runs.
+ * The last FLIGHT_WINDOW_S seconds are dumped when the server crashes, on
+ * SIGUSR1, and after a tick slower than FLIGHT_SLOW_TICK_US.
+ * intwars --flight <dump> prints a dump.
+ */
+
+#ifndef _FLIGHT_RECORDER_H
+#define _FLIGHT_RECORDER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+#include "stdafx.h"
+
+#define FLIGHT_MAGIC 0x52465749      // "IWFR"
+#define FLIGHT_VERSION 1
+#define FLIGHT_SLOTS 65536           // A power of two, 16 MB of slots
+#define FLIGHT_SLOT_DATA 224         // Message bytes kept per event, the rest is cut
+#define FLIGHT_WINDOW_S 30           // Seconds of events written in a dump
+#define FLIGHT_SLOW_TICK_US 100000   // Ticks longer than this dump the recorder, once per window at most
+#define FLIGHT_DUMP_BUFFER 65536
+
+enum FlightEventType : uint8 {
+   FLIGHT_INBOUND = 1,     // value is a FlightResult
+   FLIGHT_OUTBOUND = 2,    // value is the ENet packet flags
+   FLIGHT_TICK = 3,        // value is the tick's duration in microseconds
+   FLIGHT_CONNECT = 4,
+   FLIGHT_DISCONNECT = 5
+};
+
+enum FlightResult : uint8 {
+   FLIGHT_REFUSED = 0,     // The handler returned false
+   FLIGHT_HANDLED = 1,
+   FLIGHT_UNHANDLED = 2,   // No handler for the opcode on this channel
+   FLIGHT_PENDING = 3      // The handler hadn't returned yet
+};
+
+#pragma pack(push, 1)
+struct FlightHeader {
+   uint32 magic;
+   uint16 version;
+   uint16 slotData;        // FLIGHT_SLOT_DATA of the server that wrote it
+   uint64 startTime;       // Unix time the recorder started, event times are relative to it
+   uint64 events;          // Events recorded since the start, the dump holds the last ones
+};
+
+// Followed by min(length, slotData) bytes of the message
+struct FlightEvent {
+   uint64 time;            // Microseconds since the recorder started
+   uint32 tick;
+   uint32 value;
+   uint32 length;
+   uint16 peer;
+   FlightEventType type;
+   uint8 channel;
+};
+#pragma pack(pop)
+
+struct FlightSlot {
+   std::atomic<uint64> sequence;   // Index of the event plus one once written, 0 while it's being written
+   FlightEvent event;
+   uint8 data[FLIGHT_SLOT_DATA];
+};
+
+class FlightRecorder {
+
+private:
+   FlightSlot* slots;
+   std::atomic<uint64> next;
+   std::atomic<bool> dumping;
+   std::chrono::steady_clock::time_point start;
+   uint64 startTime;
+   uint64 lastSlowDump;
+   uint8 dumpBuffer[FLIGHT_DUMP_BUFFER];
+
+   FlightRecorder();
+
+public:
+   static FlightRecorder& getInstance();
+
+   uint64 now() const {
+      return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+   }
+
+   /**
+    * @return the index of the event, for setValue
+    */
+   uint64 record(FlightEventType type, uint32 tick, uint16 peer, uint8 channel, uint32 value, const uint8* data = 0, uint32 length = 0) {
+      uint64 index = next.fetch_add(1, std::memory_order_relaxed);
+      FlightSlot& slot = slots[index & (FLIGHT_SLOTS-1)];
+      slot.sequence.store(0, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+
+      slot.event.time = now();
+      slot.event.tick = tick;
+      slot.event.value = value;
+      slot.event.length = length;
+      slot.event.peer = peer;
+      slot.event.type = type;
+      slot.event.channel = channel;
+      if(length) {
+         memcpy(slot.data, data, length < FLIGHT_SLOT_DATA ? length : FLIGHT_SLOT_DATA);
+      }
+
+      slot.sequence.store(index+1, std::memory_order_release);
+      return index;
+   }
+
+   /**
+    * Changes the value of an event, unless its slot was reused since
+    */
+   void setValue(uint64 index, uint32 value) {
+      FlightSlot& slot = slots[index & (FLIGHT_SLOTS-1)];
+      // The slot stays published, a dump reads either value
+      if(slot.sequence.load(std::memory_order_relaxed) == index+1) {
+         slot.event.value = value;
+      }
+   }
+
+   /**
+    * Records a tick, and dumps the recorder if it was slow
+    */
+   void recordTick(uint32 tick, uint32 durationUs);
+
+   /**
+    * Dumps the recorder if SIGUSR1 was received since the last call
+    */
+   void poll(uint32 tick);
+
+   /**
+    * Dumps the crashes, and SIGUSR1 on the next poll
+    */
+   void installHandlers();
+
+   /**
+    * Writes the last FLIGHT_WINDOW_S seconds of events. Only uses system
+    * calls, so it can run in a signal handler; a dump already running makes
+    * it return false.
+    */
+   bool dump(const char* fileName);
+
+   /**
+    * Prints a dump as text
+    */
+   static bool print(const char* fileName);
+
+};
+
+#endif
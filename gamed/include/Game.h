@@ -23,6 +23,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <intlib/blowfish.h>
 
 #include "Map.h"
+#include "GameData.h"
+#include "Journal.h"
+#include "JobSystem.h"
 #include "common.h"
 #include "Client.h"
 #include "Packets.h"
@@ -31,6 +34,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define PEER_MTU 996
 #define RELIABLE ENET_PACKET_FLAG_RELIABLE
 #define UNRELIABLE 0
+#define DEFAULT_PEER_CAPACITY 32 // Up to ENET_PROTOCOL_MAXIMUM_PEER_ID, peers are only set up when they connect
 
 #define peerInfo(p) ((ClientInfo*)p->data)
 
@@ -40,11 +44,28 @@ class Game
 		Game();
 		~Game();
 
-		bool initialize(ENetAddress *address, const char *baseKey);
+		/**
+		 * @param snapshotFile if set, the game resumes from this snapshot
+		 * @param peerCapacity most clients connected at once
+		 */
+		bool initialize(ENetAddress *address, const char *baseKey, const char *snapshotFile = 0, uint32 peerCapacity = DEFAULT_PEER_CAPACITY);
 		void netLoop();
+		
+		/**
+		 * Re-runs a recorded game from its journal, without network and as
+		 * fast as possible
+		 */
+		bool replay(const char *journalFile, const char *baseKey);
+		
+		/**
+		 * Saves the whole game state between two ticks, see Snapshot.h
+		 */
+		bool saveSnapshot(const char *fileName);
+		bool restoreSnapshot(const char *fileName);
       
    
 		bool handlePacket(ENetPeer *peer, ENetPacket *packet, uint8 channelID);
+		bool dispatchPacket(ENetPeer *peer, ENetPacket *packet, uint8 channelID);
 
 		// Handlers
 		bool handleNull(HANDLE_ARGS);
@@ -70,31 +91,80 @@ class Game
       // Notifiers
       void notifyMinionSpawned(Minion* m);
       void notifySetHealth(Unit* u);
-      void notifyUpdatedStats(Unit* u);
-      void notifyMovement(Object* o);
+      void notifyUpdatedStats(const WorldFrame& frame, const UnitView& u);
+      void notifyMovement(const WorldFrame& frame, const UnitView& u);
+      
+      /**
+       * Sends the movements and stats changes of a tick, from its frame only
+       */
+      void notifyWorldFrame(const WorldFrame& frame);
+      void notifyAttackEvents(const std::vector<AttackEvent>& events);
+      void notifyHealthUpdates(const std::vector<Unit*>& units);
    
    protected:
 		// Tools
 		void printPacket(const uint8 *buf, uint32 len);
 		void printLine(uint8 *buf, uint32 len);
+		/**
+		 * Packets are queued in the peers' send queues, and really sent by flushSendQueues
+		 */
 		bool sendPacket(ENetPeer *peer, const uint8 *data, uint32 length, uint8 channelNo, uint32 flag = RELIABLE);
       bool sendPacket(ENetPeer *peer, const Packet& packet, uint8 channelNo, uint32 flag = RELIABLE);
-		bool broadcastPacket(uint8 *data, uint32 length, uint8 channelNo, uint32 flag = RELIABLE);
+		bool broadcastPacket(const uint8 *data, uint32 length, uint8 channelNo, uint32 flag = RELIABLE);
+      bool broadcastPacket(const Packet& packet, uint8 channelNo, uint32 flag = RELIABLE);
+      void flushSendQueues(uint32 elapsed);
+      void resync(ENetPeer *peer);
 
 	private:
 		bool _isAlive, _started;
 		ENetHost *_server;
 		BlowFish *_blowfish;
       ENetPeer* currentPeer;
+      JournalWriter _journal;
+      uint32 _tick;
+      std::vector<Champion*> _restoredChampions; // Waiting for their players to reconnect
+      
+      bool initializeGame(const char *baseKey, uint32 seed);
+      void onConnect(ENetPeer *peer);
+      void onDisconnect(ENetPeer *peer);
+      void updateMap(uint16 diff);
+      
+      /**
+       * Calls f on every connected client, only walking the host's active peers
+       */
+      template<typename F>
+      void forEachClient(F f) {
+         if(!_server) {
+            return;
+         }
+         
+         for(ENetListIterator it = enet_list_begin(&_server->activePeers); it != enet_list_end(&_server->activePeers); it = enet_list_next(it)) {
+            ENetPeer *peer = enet_host_active_peer(it);
+            if(peer->state == ENET_PEER_STATE_CONNECTED && peer->data) {
+               f(peer);
+            }
+         }
+      }
       
       void registerHandler(bool (Game::*handler)(HANDLE_ARGS), PacketCmd pktcmd,Channel c);
       bool (Game::*_handlerTable[0x100][0x7])(HANDLE_ARGS);
       void initHandlers();
       
       Map* map;
+      std::vector<float> statsBuffer;
+      std::vector<OutboundPacket> outgoing;                    // Taken from every send queue by flushSendQueues, sent by the next one
+      std::vector<BlowFish*> outgoingKeys;                     // Key of each packet in outgoing
+      std::vector<std::pair<ENetPeer*, uint32> > outgoingPeers; // Each peer's end in outgoing, no peer once it disconnected
+      
+      /**
+       * Encrypts a range of outgoing on the workers, while the server loop goes on
+       */
+      struct EncryptOutgoing {
+         Game* game;
+         void operator()(uint32 begin, uint32 end, uint32 worker);
+      } encryptOutgoing;
+      JobSystem::JobGroup encryptGroup;
 };
 
-extern uint32 GetNewNetID();
-
 #endif
 
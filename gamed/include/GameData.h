@@ -0,0 +1,155 @@
+/**
+ * Champion, spell and item definitions.
+ * They are written in data/gamedata.txt, compiled offline by compiledata into
+ * a binary blob, which the server maps in memory as is at startup.
+ */
+
+#ifndef _GAME_DATA_H
+#define _GAME_DATA_H
+
+#include <string>
+
+#include "stdafx.h"
+
+#define GAMEDATA_FILE "gamedata.bin"
+#define GAMEDATA_MAGIC 0x44475749 // "IWGD"
+#define GAMEDATA_VERSION 1
+
+#define DATA_NAME_LENGTH 32
+#define ITEM_MAX_MODIFIERS 6
+
+/**
+ * FNV-1a hash of a definition name, usable in case labels
+ */
+constexpr uint32 HashName(const char* s, uint32 hash = 2166136261u) {
+   return *s ? HashName(s+1, (hash ^ (uint8)*s) * 16777619u) : hash;
+}
+
+inline uint32 HashName(const std::string& s) {
+   return HashName(s.c_str());
+}
+
+enum DataKind : uint16 {
+   DATA_NONE = 0,
+   DATA_CHAMPION = 1,
+   DATA_SPELL = 2,
+   DATA_ITEM = 3
+};
+
+/* Every record below is 4-byte aligned and must keep its layout, any change
+   requires bumping GAMEDATA_VERSION */
+
+struct GameDataHeader {
+   uint32 magic;
+   uint16 version;
+   uint16 reserved;
+   uint32 size;
+   uint32 bucketCount;    // Power of two
+   uint32 bucketOffset;
+   uint32 championCount;
+   uint32 championOffset;
+   uint32 spellCount;
+   uint32 spellOffset;
+   uint32 itemCount;
+   uint32 itemOffset;
+};
+
+/**
+ * Open addressing hash table slot, keyed by (kind, name hash).
+ * Items are keyed by their id instead of a name hash.
+ */
+struct GameDataBucket {
+   uint32 key;
+   uint16 kind;
+   uint16 index;
+};
+
+struct ChampionData {
+   uint32 nameHash;
+   char name[DATA_NAME_LENGTH];
+   float health;
+   float mana;
+   float attackDamage;
+   float range;
+   float moveSpeed;
+   float armor;
+   float magicArmor;
+   float hp5;
+   float mp5;
+   uint32 spells[4]; // Name hashes of the Q, W, E and R spells
+};
+
+struct SpellData {
+   uint32 nameHash;
+   char name[DATA_NAME_LENGTH];
+   uint32 id;
+   float castTime;
+   float cooldown[5];
+   float cost[5];
+   float damage[5];
+   float projectileSpeed;
+};
+
+struct ItemModifierData {
+   uint8 attribute; // StatAttribute
+   uint8 type;      // ModifierType
+   uint16 padding;
+   float value;
+};
+
+struct ItemData {
+   uint32 id;
+   uint32 price;
+   uint32 modifierCount;
+   ItemModifierData modifiers[ITEM_MAX_MODIFIERS];
+};
+
+class GameData {
+
+private:
+   const uint8* data;
+   uint32 size;
+   const GameDataHeader* header;
+
+#if defined(WIN32) || defined(_WIN32)
+   void* file;
+   void* mapping;
+#endif
+
+   GameData();
+   ~GameData();
+
+   const void* find(DataKind kind, uint32 key) const;
+   void unload();
+
+public:
+   /**
+    * The definitions are read-only, so every game in the process shares them
+    */
+   static GameData& getInstance();
+
+   /**
+    * Maps a compiled data file in memory, checking its header
+    * @return false if the file is missing or was built for another version
+    */
+   bool load(const std::string& fileName);
+
+   const ChampionData* getChampion(uint32 nameHash) const {
+      return (const ChampionData*)find(DATA_CHAMPION, nameHash);
+   }
+
+   const ChampionData* getChampion(const std::string& name) const {
+      return getChampion(HashName(name));
+   }
+
+   const SpellData* getSpell(uint32 nameHash) const {
+      return (const SpellData*)find(DATA_SPELL, nameHash);
+   }
+
+   const ItemData* getItem(uint32 id) const {
+      return (const ItemData*)find(DATA_ITEM, id);
+   }
+
+};
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * Work-stealing job scheduler of the process.
+ * A parallel loop is cut in chunks spread over the workers' queues. Each
+ * worker pops its own chunks from the back, and steals from the front of
+ * the others' queues once it runs out. The calling thread works too while
+ * it waits for a loop.
+ * Each loop counts its own chunks in a JobGroup, so a loop can run in the
+ * background while the caller starts and waits for others. Loops are only
+ * submitted and waited for by one thread, the server loop's: it runs chunks
+ * as worker 0, so a second caller would share its scratch data.
+ */
+
+#ifndef _JOB_SYSTEM_H
+#define _JOB_SYSTEM_H
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "stdafx.h"
+
+class JobSystem {
+
+public:
+   /**
+    * Runs the items [begin, end) of a loop. worker is the index of the
+    * running thread, from 0 to getWorkerCount()-1, for per-thread scratch data.
+    */
+   typedef void (*JobFunction)(void* context, uint32 begin, uint32 end, uint32 worker);
+
+   /**
+    * Chunks of a loop not finished yet
+    */
+   class JobGroup {
+      friend class JobSystem;
+      std::atomic<uint32> remaining;
+
+   public:
+      JobGroup() : remaining(0) { }
+      bool isDone() const { return remaining.load(std::memory_order_acquire) == 0; }
+   };
+
+private:
+   struct Job {
+      JobFunction function;
+      void* context;
+      uint32 begin, end;
+      std::atomic<uint32>* remaining; // Of the job's group
+   };
+
+   struct WorkerQueue {
+      std::mutex lock;
+      std::deque<Job> jobs;
+   };
+
+   std::vector<WorkerQueue*> queues;  // Queue 0 belongs to the calling thread
+   std::vector<std::thread> threads;
+   std::thread::id caller;            // The one thread submitting loops
+
+   std::mutex wakeLock;
+   std::condition_variable wake;
+   uint32 generation;                 // Bumped for every loop, wakes the workers up
+   bool stopping;
+
+   JobSystem(uint32 threadCount);
+   ~JobSystem();
+
+   bool popOrSteal(uint32 worker, Job& job);
+   void execute(const Job& job, uint32 worker);
+   void workerLoop(uint32 worker);
+   void submit(JobGroup& group, uint32 count, uint32 grain, JobFunction function, void* context);
+
+   template<typename F>
+   static void invoke(void* context, uint32 begin, uint32 end, uint32 worker) {
+      (*static_cast<F*>(context))(begin, end, worker);
+   }
+
+public:
+   static JobSystem& getInstance();
+
+   uint32 getWorkerCount() const { return queues.size(); }
+
+   /**
+    * Calls f(begin, end, worker) over [0, count) in chunks of grain items,
+    * and waits for all of them. Chunks run in any order on any thread, so f
+    * must only write to data owned by its items or its worker.
+    */
+   template<typename F>
+   void parallelFor(uint32 count, uint32 grain, F& f) {
+      // Not worth waking anyone up
+      if(queues.size() == 1 || count <= grain) {
+         assert(std::this_thread::get_id() == caller);
+         if(count) {
+            f(0, count, 0);
+         }
+         return;
+      }
+
+      JobGroup group;
+      submit(group, count, grain, &invoke<F>, &f);
+      wait(group);
+   }
+
+   /**
+    * Same as parallelFor, but returns at once. f must stay alive until the
+    * group is waited for.
+    */
+   template<typename F>
+   void parallelForAsync(JobGroup& group, uint32 count, uint32 grain, F& f) {
+      submit(group, count, grain, &invoke<F>, &f);
+   }
+
+   /**
+    * Runs chunks until every chunk of the group is done
+    */
+   void wait(JobGroup& group);
+
+};
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ * Append-only record of everything that drives a game: connections, every
+ * accepted client packet once decrypted, the players' view delays and the
+ * duration of each tick.
+ * Replaying a journal without network re-runs the exact same game, as fast
+ * as the machine allows.
+ */
+
+#ifndef _JOURNAL_H
+#define _JOURNAL_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "stdafx.h"
+
+#define JOURNAL_MAGIC 0x4E4A5749 // "IWJN"
+#define JOURNAL_VERSION 2       // Version 1 journals have no view delays, they still replay
+#define JOURNAL_FLUSH_SIZE 4096  // Bytes buffered before hitting the file
+
+enum JournalRecordType : uint8 {
+   JOURNAL_TICK = 1,       // uint16 diff
+   JOURNAL_CONNECT = 2,    // uint16 peer
+   JOURNAL_DISCONNECT = 3, // uint16 peer
+   JOURNAL_PACKET = 4,     // uint32 tick, uint16 peer, uint8 channel, uint16 length, data
+   JOURNAL_VIEW_DELAY = 5  // uint16 peer, uint32 delay, written before the tick it applies to
+};
+
+struct JournalHeader {
+   uint32 magic;
+   uint16 version;
+   uint16 reserved;
+   uint32 seed;     // Random seed the game was started with
+};
+
+struct JournalRecord {
+   JournalRecordType type;
+   uint32 tick;
+   uint16 diff;
+   uint16 peer;
+   uint8 channel;
+   uint32 viewDelay;
+   std::vector<uint8> data;
+};
+
+class JournalWriter {
+
+private:
+   FILE* file;
+   std::vector<uint8> buffer;
+
+   template<typename T>
+   void put(const T& value) {
+      buffer.insert(buffer.end(), (const uint8*)&value, (const uint8*)&value + sizeof(T));
+   }
+
+   void commit();
+
+public:
+   JournalWriter() : file(0) { }
+   ~JournalWriter() { close(); }
+
+   bool open(const std::string& fileName, uint32 seed);
+   void close();
+   void flush();
+   bool isOpen() const { return file != 0; }
+
+   void writeTick(uint16 diff);
+   void writeConnect(uint16 peer);
+   void writeDisconnect(uint16 peer);
+   void writePacket(uint32 tick, uint16 peer, uint8 channel, const uint8* data, uint16 length);
+   void writeViewDelay(uint16 peer, uint32 delay);
+
+};
+
+class JournalReader {
+
+private:
+   FILE* file;
+   JournalHeader header;
+
+   template<typename T>
+   bool get(T& value) {
+      return fread(&value, sizeof(T), 1, file) == 1;
+   }
+
+public:
+   JournalReader() : file(0) { }
+   ~JournalReader();
+
+   bool open(const std::string& fileName);
+   uint32 getSeed() const { return header.seed; }
+
+   /**
+    * @return false at the end of the journal, or if it is truncated
+    */
+   bool next(JournalRecord& record);
+
+};
+
+#endif
@@ -6,26 +6,101 @@
 
 #include "stdafx.h"
 #include "Object.h"
+#include "AutoAttack.h"
 #include "Client.h"
+#include "DamageQueue.h"
+#include "MissilePool.h"
+#include "PositionHistory.h"
+#include "Targeting.h"
+#include "TimerWheel.h"
+#include "WaveSpawner.h"
+#include "WorldState.h"
+
+#define FIRST_NET_ID 0x40000019
 
 class Game;
+class SnapshotReader;
+class SnapshotWriter;
+class Turret;
 
 class Map {
 
 private:
    std::map<uint32, Object*> objects;
+   std::vector<Object*> updateList;  // Snapshot of objects for the parallel phases
+   std::vector<Object*> removedList; // Removed this tick, deleted once captured in the frame
    std::vector<ClientInfo*> players;
+   std::vector<Champion*> champions;
+   Turret* turrets;     // Static structures, packed and never walked by update()
+   uint32 nextNetId;
+   uint32 turretCount;
+   uint32 firstTurretId;
    Game* game;
+   TimerWheel timers;
+   Targeting targeting;
+   MissilePool missiles;
+   DamageQueue damage;
+   std::vector<AttackEvent> attackEvents;
+   std::vector<Unit*> damagedUnits;
+   WaveSpawner waves;
+   WorldState world;
+   PositionHistory history;
    
 public:
-   Map(Game* game) : game(game) { }
+   Map(Game* game);
    
-   virtual ~Map() { }
+   virtual ~Map();
    virtual void update(unsigned int diff);
+   
+   /**
+    * Starts the waves and wakes the structures up
+    */
+   void start();
    Object* getObjectById(uint32 id);
    void addObject(Object* o);
    
+   /**
+    * Net ids are counted per game, so a process can host or restore a game
+    * next to others without their ids colliding
+    */
+   uint32 getNewNetId() { return nextNetId++; }
+   uint32 peekNetId() const { return nextNetId; }
+   void setNextNetId(uint32 id) { nextNetId = id; }
+   
+   /**
+    * Queues an attack for the clients, the events are sent together at the end of the tick
+    */
+   void addAttackEvent(Unit* source, Unit* target);
+   
+   /**
+    * Marks every stat of every unit changed, so they all go in the next frame
+    */
+   void markAllStatsUpdated();
+   
+   /**
+    * Saves the clock, the waves, the missiles, the structures and every
+    * champion and minion. Projectiles are short-lived and aren't kept.
+    */
+   void save(SnapshotWriter& s) const;
+   
+   /**
+    * Restores a snapshot into a freshly built map
+    * @param champions receives the restored champions, for the players to take back
+    */
+   bool load(SnapshotReader& s, std::vector<Champion*>& champions);
+   
    const std::map<uint32, Object*>& getObjects() { return objects; }
+   const std::vector<Champion*>& getChampions() { return champions; }
+   Turret* getTurrets() { return turrets; }
+   uint32 getTurretCount() const { return turretCount; }
+   TimerWheel& getTimers() { return timers; }
+   Targeting& getTargeting() { return targeting; }
+   MissilePool& getMissiles() { return missiles; }
+   DamageQueue& getDamage() { return damage; }
+   WaveSpawner& getWaves() { return waves; }
+   WorldState& getWorld() { return world; }
+   PositionHistory& getHistory() { return history; }
+   Game* getGame() const { return game; }
 
 };
 
@@ -28,6 +28,8 @@ public:
    Minion(Map* map, uint32 id, MinionSpawnType type, MinionSpawnPosition position);
    uint32 getPosition() const { return position; }
    uint32 getType() const { return type; }
+   UnitKind getKind() const { return UNIT_MINION; }
+   void die(Unit* killer);
 
 };
 
@@ -29,12 +29,12 @@ enum MinionFieldMaskFive : uint32
 class MinionStats : public Stats {
 
 public:
-   float getMaxHealth() const {
-      return getStat(MM_Four, Minion_FM4_MaxHp);
-   }
-
-   void setMaxHealth(float health) {
-      setStat(MM_Four, Minion_FM4_MaxHp, health);
+   /**
+    * Minions use a different field layout than champions, so the shared
+    * accessors are redirected through the field masks instead of overrides
+    */
+   MinionStats() {
+      maxHealthField = Minion_FM4_MaxHp;
    }
 
 };
@@ -0,0 +1,58 @@
+#ifndef _MISSILE_POOL_H
+#define _MISSILE_POOL_H
+
+#include <vector>
+
+#include "stdafx.h"
+
+#define MISSILE_POOL_SIZE 1024
+
+class Map;
+class SnapshotReader;
+class SnapshotWriter;
+class Unit;
+
+/**
+ * Homing basic attack missile, following its target until it lands
+ */
+struct Missile {
+   uint32 ownerId;
+   uint32 targetId;
+   float x, y;
+   float speed;
+   float damage;
+};
+
+/**
+ * Fixed-size pool of in-flight missiles. Missiles are plain values, the
+ * active ones are kept packed at the front so updating them is a linear
+ * walk, and nothing is allocated once the map is built.
+ */
+class MissilePool {
+
+private:
+   Map* map;
+   std::vector<Missile> missiles;
+   uint32 activeCount;
+
+public:
+   MissilePool(Map* map) : map(map), missiles(MISSILE_POOL_SIZE), activeCount(0) { }
+
+   /**
+    * @return false if the pool is exhausted, the caller should then apply the damage right away
+    */
+   bool launch(Unit* owner, Unit* target, float damage, float speed);
+
+   /**
+    * Moves every missile towards its target, dealing damage to the ones that land
+    */
+   void update(unsigned int diff);
+
+   uint32 getActiveCount() const { return activeCount; }
+   
+   void save(SnapshotWriter& s) const;
+   void load(SnapshotReader& s);
+
+};
+
+#endif
@@ -12,6 +12,8 @@
 #include "stdafx.h"
 
 class Map;
+class SnapshotReader;
+class SnapshotWriter;
 
 #define MAP_WIDTH (13982 / 2)
 #define MAP_HEIGHT (14446 / 2)
@@ -21,7 +23,7 @@ struct MovementVector {
     short y;
     
     MovementVector() : x(0), y(0){ }
-    MovementVector(uint16 x, uint16 y) : x(x), y(x) { }
+    MovementVector(short x, short y) : x(x), y(y) { }
     Target* toTarget() { return new Target(2.0*x + MAP_WIDTH, 2.0*y + MAP_HEIGHT); }
 };
 
@@ -61,6 +63,16 @@ public:
     void setSide(unsigned int side) { this->side = side; }
     unsigned int getSide() { return side; }
 
+    /**
+    * Parallel part of the update: moves the object towards a fixed point.
+    * It may run concurrently with the other objects' integrate(), so it must
+    * only touch the object itself.
+    */
+    virtual void integrate(unsigned int diff);
+    
+    /**
+    * Serial part of the update, anything reading or writing other objects
+    */
     virtual void update(unsigned int diff);
     virtual float getMoveSpeed() const = 0;
 
@@ -81,7 +93,18 @@ public:
 
     void setPosition(float x, float y);
 
+    /**
+    * Saves the object's state, the map saves what's needed to construct it
+    */
+    virtual void save(SnapshotWriter& s) const;
+    virtual void load(SnapshotReader& s);
+
     bool collide(Object* o);
+    
+    /**
+     * Same as collide, with o somewhere else than where it is now
+     */
+    bool collideAt(Object* o, float x, float y);
     bool isPointInHitbox(float x, float y);
 };
 
@@ -0,0 +1,98 @@
+/**
+ * Size class allocator behind ENet's malloc and free callbacks.
+ * Packets, their data, outgoing commands and acknowledgements are carved
+ * from large slabs and go back to the free list of their class, so once the
+ * pool is warm sending and receiving never reach the general allocator.
+ * Only blocks larger than the biggest class, like big reassembled
+ * fragments, still do. The send queues and the packet builders' buffers
+ * allocate from it too, through PoolAllocator.
+ * Not thread safe, like ENet itself: only the thread servicing the hosts
+ * may create and destroy packets.
+ */
+
+#ifndef _PACKET_POOL_H
+#define _PACKET_POOL_H
+
+#include <new>
+#include <vector>
+
+#include "stdafx.h"
+
+#define POOL_CLASSES 8         // 32 bytes to 4 KB, each class doubling the previous one
+#define POOL_MIN_BLOCK 32
+#define POOL_HEADER_SIZE 16    // Keeps the blocks 16 bytes aligned
+#define POOL_SLAB_SIZE 65536
+
+struct PacketPoolStats {
+   uint64 allocations;
+   uint64 frees;
+   uint64 fallbacks;               // Allocations too large for any class
+   uint32 slabs;
+   uint32 inUse[POOL_CLASSES];
+   uint32 peak[POOL_CLASSES];
+};
+
+class PacketPool {
+
+private:
+   struct FreeBlock {
+      FreeBlock* next;
+   };
+
+   FreeBlock* freeLists[POOL_CLASSES];
+   std::vector<void*> slabs;
+   PacketPoolStats stats;
+
+   PacketPool();
+   ~PacketPool();
+
+   void refill(uint32 sizeClass);
+
+public:
+   static PacketPool& getInstance();
+
+   /**
+    * Makes ENet allocate from the pool, call instead of enet_initialize
+    * @return enet_initialize's result
+    */
+   static int initializeENet();
+
+   void* allocate(size_t size);
+   void release(void* memory);
+
+   const PacketPoolStats& getStats() const { return stats; }
+   void printStats() const;
+
+};
+
+/**
+ * Standard allocator drawing from the pool, for the containers of the send
+ * path. Same thread as the pool only.
+ */
+template<typename T>
+struct PoolAllocator {
+   typedef T value_type;
+
+   PoolAllocator() { }
+   template<typename U> PoolAllocator(const PoolAllocator<U>&) { }
+
+   T* allocate(size_t n) {
+      T* p = (T*)PacketPool::getInstance().allocate(n*sizeof(T));
+      if(!p) {
+         throw std::bad_alloc();
+      }
+      return p;
+   }
+
+   void deallocate(T* p, size_t) {
+      PacketPool::getInstance().release(p);
+   }
+};
+
+template<typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) { return true; }
+
+template<typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) { return false; }
+
+#endif
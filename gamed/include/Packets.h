@@ -20,7 +20,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <time.h>
 #include <cmath>
-#include <set>
 
 #include <intlib/general.h>
 #include <enet/enet.h>
@@ -29,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Buffer.h"
 #include "Client.h"
 #include "Minion.h"
+#include "WorldState.h"
 
 #if defined( __GNUC__ )
 #pragma pack(1)
@@ -788,36 +788,27 @@ public:
 
 class UpdateStats : public GamePacket {
 public:
-   UpdateStats(Unit* u) : GamePacket(PKT_S2C_CharStats, u->getNetId()) {
-      const std::multimap<uint8, uint32>& stats = u->getStats().getUpdatedStats();
-      
-      std::set<uint8> masks;
-      uint8 masterMask = 0;
-      
-      for(auto& p : stats) {
-         masterMask |= p.first;
-         masks.insert(p.first);
-      }
-      
+   /**
+    * @param masks one mask per block set in masterMask, then the values of their fields in order
+    */
+   UpdateStats(uint32 netId, uint8 masterMask, const uint32* masks, const float* values) : GamePacket(PKT_S2C_CharStats, netId) {
       buffer << (uint8)1;
       buffer << masterMask;
-      buffer << u->getNetId();
+      buffer << netId;
       
-      for(uint8 m : masks) {
-         uint32 mask = 0;
-         
-         for(auto it = stats.lower_bound(m); it != stats.upper_bound(m); ++it) {
-            mask |= it->second;
+      for(int i = 0; i < 5; ++i) {
+         if(!(masterMask & (1 << i))) {
+            continue;
          }
          
+         uint32 mask = *masks++;
+         uint32 count = __builtin_popcount(mask);
+         
          buffer << mask;
-         buffer << (uint8)(stats.count(m)*4);
+         buffer << (uint8)(count*4);
          
-         for(int i = 0; i < 32; ++i) {
-            uint32 tmpMask = (1 << i);
-            if(tmpMask & mask) {
-               buffer << u->getStats().getStat(m, tmpMask);
-            }
+         for(uint32 j = 0; j < count; ++j) {
+            buffer << *values++;
          }
       }
    }
@@ -0,0 +1,52 @@
+/**
+ * Where every unit was during the last ticks, for lag compensation.
+ * A client aims at units as it saw them, about a round trip ago, so
+ * skillshots test their hits against the targets rewound to that time.
+ * Positions are kept per unit in a ring of frames, x and y in separate
+ * arrays, so rewinding a unit only reads two short contiguous runs.
+ */
+
+#ifndef _POSITION_HISTORY_H
+#define _POSITION_HISTORY_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "stdafx.h"
+
+#define HISTORY_FRAMES 64           // Ticks kept, a power of two
+#define HISTORY_MAX_REWIND 250      // Default limit on how far back hits are checked, in milliseconds
+
+struct WorldFrame;
+
+class PositionHistory {
+
+private:
+   std::vector<float> xs, ys;       // HISTORY_FRAMES entries per slot
+   uint64 times[HISTORY_FRAMES];
+   uint32 frameCount;               // Frames recorded so far, the latest is at (frameCount-1) % HISTORY_FRAMES
+   std::unordered_map<uint32, uint32> slots;
+   std::vector<uint32> freeSlots;
+   uint32 maxRewind;
+
+public:
+   PositionHistory() : frameCount(0), maxRewind(HISTORY_MAX_REWIND) { }
+
+   /**
+    * Adds the positions of the units of a frame, and forgets the removed ones
+    */
+   void record(const WorldFrame& frame);
+
+   /**
+    * Position of a unit at a past time, between the two frames around it.
+    * Times older than the history get the oldest position.
+    * @return false if the unit isn't in the history
+    */
+   bool getPosition(uint32 netId, uint64 time, float& x, float& y) const;
+
+   void setMaxRewind(uint32 milliseconds) { maxRewind = milliseconds; }
+   uint32 getMaxRewind() const { return maxRewind; }
+
+};
+
+#endif
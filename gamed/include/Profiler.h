@@ -0,0 +1,122 @@
+/**
+ * Phase timers of the server loop, cheap enough to stay on.
+ * A PROFILE_SCOPE reads the CPU's time stamp counter when it's entered and
+ * left, and writes one sample in its thread's ring, the oldest samples
+ * being overwritten. The rings can be written on demand as a Chrome trace
+ * (chrome://tracing or Perfetto), and every tick slower than
+ * PROFILE_SLOW_TICK_US prints a summary of where its time went.
+ * Writers never lock: the job system's workers may still be writing while
+ * the rings are read, so a reader copies each sample and drops it if its
+ * slot was overwritten meanwhile.
+ */
+
+#ifndef _PROFILER_H
+#define _PROFILER_H
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#if defined(_MSC_VER)
+   #include <intrin.h>
+#elif defined(__i386__) || defined(__x86_64__)
+   #include <x86intrin.h>
+#else
+   #include <chrono>
+#endif
+
+#include "stdafx.h"
+
+#define PROFILE_RING_SIZE 65536       // Samples kept per thread, a power of two
+#define PROFILE_SLOW_TICK_US 20000    // Ticks longer than this print their summary
+#define PROFILE_SUMMARY_PHASES 6      // Slowest phases listed in the summary
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+
+/**
+ * Times the rest of the enclosing block. name must be a string literal.
+ */
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(_profileScope, __LINE__)(name)
+
+struct ProfileSample {
+   const char* name;
+   uint64 start, end;   // Time stamp counter
+};
+
+struct ProfileRing {
+   uint32 thread;                // Index of the thread, in registration order
+   std::atomic<uint64> count;    // Samples written since the start, the last ones are kept
+   ProfileSample samples[PROFILE_RING_SIZE];
+};
+
+class Profiler {
+
+private:
+   std::mutex lock;
+   std::vector<ProfileRing*> rings;
+   uint64 startCounter;
+   uint64 startNs;
+   double countsPerUs;
+   uint32 slowTicks;
+
+   Profiler();
+
+   ProfileRing* registerThread();
+   static bool readSample(const ProfileRing* ring, uint64 index, ProfileSample& sample);
+   double toUs(uint64 counter) const { return (counter - startCounter) / countsPerUs; }
+
+public:
+   static Profiler& getInstance();
+
+   static uint64 now() {
+#if defined(_MSC_VER) || defined(__i386__) || defined(__x86_64__)
+      return __rdtsc();
+#else
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+   }
+
+   void record(const char* name, uint64 start, uint64 end) {
+      static thread_local ProfileRing* ring = 0;
+      if(!ring) {
+         ring = registerThread();
+      }
+
+      uint64 count = ring->count.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release); // The previous count is seen before the slot changes
+      ProfileSample& sample = ring->samples[count & (PROFILE_RING_SIZE-1)];
+      sample.name = name;
+      sample.start = start;
+      sample.end = end;
+      ring->count.store(count+1, std::memory_order_release);
+   }
+
+   /**
+    * Records the tick that began at start, and prints where its time went if it was slow
+    * @return the tick's duration in microseconds
+    */
+   double endTick(uint32 tick, uint64 start);
+
+   /**
+    * Writes the samples of every thread as Chrome trace events
+    */
+   bool writeTrace(const char* fileName);
+
+   uint32 getSlowTicks() const { return slowTicks; }
+
+};
+
+class ProfileScope {
+
+private:
+   const char* name;
+   uint64 start;
+
+public:
+   explicit ProfileScope(const char* name) : name(name), start(Profiler::now()) { }
+   ~ProfileScope() { Profiler::getInstance().record(name, start, Profiler::now()); }
+
+};
+
+#endif
@@ -13,14 +13,20 @@ protected:
    std::vector<Object*> objectsHit;
    Spell* originSpell;
    float moveSpeed;
+   uint32 rewind; // Skillshots hit the units where their caster saw them, this long ago
 
 public:
-   Projectile(Map* map, uint32 id, float x, float y, int hitboxWidth, int hitboxHeight, Target* target, Spell* originSpell, float moveSpeed) : Object(map, id, x, y, hitboxWidth, hitboxHeight), originSpell(originSpell), moveSpeed(moveSpeed) {
-      setTarget(target);
-   }
+   Projectile(Map* map, uint32 id, float x, float y, int hitboxWidth, int hitboxHeight, Target* target, Spell* originSpell, float moveSpeed);
    
    void update(unsigned int diff);
    float getMoveSpeed() const { return moveSpeed; }
+   void setRewind(uint32 rewind) { this->rewind = rewind; }
+
+   /**
+    * Adds to hits every object the projectile touches, where they were
+    * when the caster saw them
+    */
+   void sweep(std::vector<Object*>& hits);
 
    
 
@@ -0,0 +1,55 @@
+/**
+ * What a peer was sent of every unit's stats.
+ * Stats are marked changed on every write, even with the same value, so
+ * each stats update is compared with what the peer already has and only
+ * the fields that really differ are sent to it.
+ * Stats go reliably, so what was handed to ENet is what the peer ends up
+ * with. A lost send or a new connection clears the record, and the map then
+ * marks every stat changed so the peer gets all of them again.
+ */
+
+#ifndef _REPLICATED_STATE_H
+#define _REPLICATED_STATE_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "stdafx.h"
+
+struct ReplicatedStats {
+   uint32 known[5];     // Fields the peer has a value for, per block
+   float values[5][32];
+};
+
+class ReplicatedState {
+
+private:
+   std::unordered_map<uint32, ReplicatedStats> units;
+
+   ReplicatedStats& getUnit(uint32 netId);
+
+public:
+   /**
+    * Keeps the fields of a stats update the peer doesn't have yet, and
+    * records them as sent
+    * @param masks one mask per block of masterMask, values in the same order as the packets
+    * @return the master mask of the fields left in outMasks and outValues
+    */
+   uint8 filterStats(uint32 netId, uint8 masterMask, const uint32* masks, const float* values, uint32 outMasks[5], std::vector<float>& outValues);
+
+   /**
+    * Records a field the peer was sent by another packet, like SetHealth
+    * @param blockId master mask value of the field's block, such as MM_Four
+    */
+   void recordStat(uint32 netId, uint8 blockId, uint32 field, float value);
+
+   /**
+    * Drops a removed unit
+    */
+   void forget(uint32 netId) { units.erase(netId); }
+
+   void clear() { units.clear(); }
+
+};
+
+#endif
@@ -0,0 +1,104 @@
+/**
+ * Outbound packets of a peer, waiting for their turn.
+ * Each channel has a priority class, and packets are sent class by class
+ * within a byte budget refilled from the peer's bandwidth and ENet's
+ * throttle, so a slow link gets combat first and the chat whenever there's
+ * room left. Packets of a channel always keep their order.
+ * A queued movement or health is replaced by a newer one for the same unit,
+ * and stats changes of a unit are merged into its pending stats packet.
+ * Flushing is split in three steps, so the packets of every peer can be
+ * encrypted together on the job system's workers: take the packets the
+ * budget allows, encrypt them, then send them in order. The server loop
+ * encrypts them in the background and sends them on its next pass.
+ * Queued packets are ENet packets from the packet pool, handed to ENet as
+ * they are, and the queues allocate from the pool too, so a warm queue
+ * never calls malloc.
+ */
+
+#ifndef _SEND_QUEUE_H
+#define _SEND_QUEUE_H
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+#include <enet/enet.h>
+
+#include "stdafx.h"
+#include "PacketPool.h"
+
+#define SEND_DEFAULT_BANDWIDTH 128000 // Bytes per second, for clients that don't advertise theirs
+#define SEND_MIN_BURST 50             // Milliseconds of budget kept at least, whatever the RTT
+
+class BlowFish;
+
+enum SendPriority : uint8 {
+   SEND_CRITICAL = 0,  // Handshake and loading, never held back
+   SEND_HIGH = 1,      // Combat
+   SEND_NORMAL = 2,    // Movement and stats
+   SEND_LOW = 3,       // Chat
+   SEND_PRIORITIES = 4
+};
+
+struct OutboundPacket {
+   ENetPacket* packet; // Owned by the queue, then by whoever took it until it's sent
+   uint8 channel;
+   uint64 key;         // Unit and packet type it updates, 0 if it can't be coalesced
+};
+
+class SendQueue {
+
+private:
+   typedef std::unordered_map<uint64, OutboundPacket*, std::hash<uint64>, std::equal_to<uint64>, PoolAllocator<std::pair<const uint64, OutboundPacket*> > > PendingMap;
+
+   typedef std::deque<OutboundPacket, PoolAllocator<OutboundPacket> > PacketDeque;
+
+   PacketDeque queues[SEND_PRIORITIES];
+   PendingMap pending; // Queued packets by key
+   std::vector<uint8> merged; // Reused to merge stats packets
+   int32 credit;  // Bytes that can still be sent, negative after a large packet
+   uint32 queuedBytes;
+
+   static uint64 getKey(const uint8* data, uint32 length);
+
+   SendQueue(const SendQueue&);
+   SendQueue& operator=(const SendQueue&);
+
+public:
+   SendQueue() : credit(0), queuedBytes(0) { }
+   ~SendQueue();
+
+   static SendPriority getPriority(uint8 channel);
+
+   /**
+    * Queues a plain packet, or folds it in the pending one for the same unit
+    */
+   void push(const uint8* data, uint32 length, uint8 channel, uint32 flags);
+
+   /**
+    * Moves as many packets as the budget allows to out, in sending order
+    * @param elapsed milliseconds since the last flush, to refill the budget
+    */
+   void take(ENetPeer* peer, uint32 elapsed, std::vector<OutboundPacket>& out);
+
+   /**
+    * Only reads the key schedule, so any thread can encrypt a taken packet
+    */
+   static void encrypt(OutboundPacket& packet, BlowFish* blowfish);
+
+   /**
+    * Hands encrypted packets to ENet, which then owns them
+    * @return false if ENet refused a packet, the peer then misses it
+    */
+   static bool send(ENetPeer* peer, OutboundPacket* packets, uint32 count);
+
+   /**
+    * Destroys taken packets that won't be sent
+    */
+   static void discard(OutboundPacket* packets, uint32 count);
+
+   uint32 getQueuedBytes() const { return queuedBytes; }
+
+};
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * Binary snapshot of a whole game: the map, every unit with its stats,
+ * modifiers, spells, attacks and AI, and every pending timer, stored as the
+ * time left before it fires.
+ * Snapshots are taken between two ticks, and restored into a fresh Game.
+ */
+
+#ifndef _SNAPSHOT_H
+#define _SNAPSHOT_H
+
+#include <string>
+#include <vector>
+
+#include "stdafx.h"
+
+#define SNAPSHOT_MAGIC 0x53535749 // "IWSS"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_NO_TIMER 0xFFFFFFFF
+
+class Timer;
+class TimerWheel;
+
+struct SnapshotHeader {
+   uint32 magic;
+   uint16 version;
+   uint16 reserved;
+   uint32 size;      // Including the header
+};
+
+class SnapshotWriter {
+
+private:
+   std::vector<uint8> buffer;
+
+public:
+   SnapshotWriter();
+
+   template<typename T>
+   void put(const T& value) {
+      buffer.insert(buffer.end(), (const uint8*)&value, (const uint8*)&value + sizeof(T));
+   }
+
+   void put(const void* data, uint32 length);
+   void putString(const std::string& s);
+
+   /**
+    * Stores the time left on a timer, or that it isn't scheduled
+    */
+   void putTimer(const Timer& timer);
+
+   /**
+    * Writes the snapshot to a file, with its header
+    */
+   bool save(const std::string& fileName);
+   uint32 size() const { return buffer.size(); }
+
+};
+
+class SnapshotReader {
+
+private:
+   std::vector<uint8> buffer;
+   uint32 position;
+   bool failed;
+
+public:
+   SnapshotReader() : position(0), failed(false) { }
+
+   /**
+    * Reads a snapshot file, checking its header
+    */
+   bool open(const std::string& fileName);
+
+   template<typename T>
+   T get() {
+      T value = T();
+      get(&value, sizeof(T));
+      return value;
+   }
+
+   void get(void* data, uint32 length);
+   std::string getString();
+
+   /**
+    * Schedules timer again with the time it had left, if it was scheduled
+    */
+   void getTimer(Timer& timer, TimerWheel& wheel);
+
+   /**
+    * @return false once a read went past the end of the snapshot
+    */
+   bool isValid() const { return !failed; }
+   void fail() { failed = true; }
+   bool isAtEnd() const { return position == buffer.size(); }
+
+};
+
+#endif
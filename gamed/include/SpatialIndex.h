@@ -0,0 +1,80 @@
+/**
+ * Uniform grid over the map, holding every unit bucketed by cell.
+ * It is rebuilt from scratch once per tick with a counting sort, which is
+ * O(n) and keeps the units of a cell contiguous in memory.
+ */
+
+#ifndef _SPATIAL_INDEX_H
+#define _SPATIAL_INDEX_H
+
+#include <map>
+#include <vector>
+
+#include "stdafx.h"
+
+class Object;
+class Turret;
+class Unit;
+
+#define SPATIAL_CELL_SIZE 512
+#define SPATIAL_GRID_SIZE 32 // Cells per side, covers 16384 units
+
+struct SpatialEntry {
+   Unit* unit;
+   float x, y;
+   uint32 side;
+   uint8 kind; // UnitKind
+};
+
+class SpatialIndex {
+
+private:
+   std::vector<uint32> cellStart; // Index of each cell's first entry, plus an end marker
+   std::vector<SpatialEntry> entries;
+   std::vector<SpatialEntry> unsorted;
+   std::vector<uint16> unsortedCells;
+
+   static int toCell(float coord) {
+      int cell = (int)coord / SPATIAL_CELL_SIZE;
+      return cell < 0 ? 0 : (cell >= SPATIAL_GRID_SIZE ? SPATIAL_GRID_SIZE-1 : cell);
+   }
+
+   void add(Unit* u);
+
+public:
+   SpatialIndex() : cellStart(SPATIAL_GRID_SIZE*SPATIAL_GRID_SIZE + 1, 0) { }
+
+   /**
+    * Indexes the dynamic objects along with the static structures
+    */
+   void rebuild(const std::map<uint32, Object*>& objects, Turret* turrets, uint32 turretCount);
+
+   /**
+    * Calls f(entry, squaredDistance) for every unit within radius of (x, y)
+    */
+   template<typename F>
+   void forEachInRadius(float x, float y, float radius, F f) const {
+      int minX = toCell(x - radius), maxX = toCell(x + radius);
+      int minY = toCell(y - radius), maxY = toCell(y + radius);
+      float radiusSq = radius*radius;
+
+      for(int cy = minY; cy <= maxY; ++cy) {
+         for(int cx = minX; cx <= maxX; ++cx) {
+            int cell = cy*SPATIAL_GRID_SIZE + cx;
+            for(uint32 i = cellStart[cell]; i < cellStart[cell+1]; ++i) {
+               const SpatialEntry& e = entries[i];
+               float dx = e.x - x, dy = e.y - y;
+               float distanceSq = dx*dx + dy*dy;
+               if(distanceSq <= radiusSq) {
+                  f(e, distanceSq);
+               }
+            }
+         }
+      }
+   }
+
+   uint32 size() const { return entries.size(); }
+
+};
+
+#endif
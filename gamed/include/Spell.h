@@ -2,10 +2,14 @@
 #define _SPELL_H
 
 #include "stdafx.h"
+#include "GameData.h"
 #include "Projectile.h"
+#include "TimerWheel.h"
 
 class Unit;
 class Champion;
+class SnapshotReader;
+class SnapshotWriter;
 
 enum SpellState {
    STATE_READY,
@@ -13,7 +17,7 @@ enum SpellState {
    STATE_COOLDOWN
 };
 
-class Spell {
+class Spell : public Timer {
 protected:
    uint32 id;
    Champion* owner;
@@ -24,15 +28,18 @@ protected:
    float castTime;
    float cooldown[5];
    float cost[5];
-   
-   float currentCooldown;
-   float currentCastTime;
 
    Unit* target;
    float x, y;
    
 public:
-   Spell(uint32 id, Champion* owner, float castTime, uint8 slot) : id(id), owner(owner), level(0), slot(slot), state(STATE_READY), castTime(castTime), currentCooldown(0), currentCastTime(0) { }
+   /**
+    * The id, cast time, cooldowns and costs come from the spell's definition
+    */
+   Spell(Champion* owner, uint8 slot, const SpellData* data) : id(data->id), owner(owner), level(0), slot(slot), state(STATE_READY), castTime(data->castTime) {
+      memcpy(cooldown, data->cooldown, sizeof(cooldown));
+      memcpy(cost, data->cost, sizeof(cost));
+   }
    
    /**
     * Called when the character casts the spell
@@ -46,9 +53,9 @@ public:
    virtual void finishCasting();
    
    /**
-    * Called every diff milliseconds to update the spell
+    * Called by the game's timers when the cast or the cooldown ends
     */
-   virtual void update(unsigned int diff);
+   virtual void onTimer();
    
    /**
     * Called by projectiles when they land / hit
@@ -101,6 +108,12 @@ public:
    uint8 getSlot() const {
       return slot;
    }
+   
+   /**
+    * The target of a spell being cast isn't kept, only its coordinates
+    */
+   void save(SnapshotWriter& s) const;
+   void load(SnapshotReader& s);
 
 };
 
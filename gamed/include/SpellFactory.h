@@ -0,0 +1,32 @@
+#ifndef _SPELL_FACTORY_H
+#define _SPELL_FACTORY_H
+
+#include "Champions/Ezreal/MysticShot.h"
+
+class SpellFactory {
+
+public:
+
+   /**
+    * Spells need a class here to script their effects, their values come
+    * from the game data.
+    * @return 0 if the spell has no definition or no script
+    */
+   static Spell* getSpellFromHash(uint32 nameHash, Champion* owner, uint8 slot) {
+      const SpellData* data = GameData::getInstance().getSpell(nameHash);
+      if(!data) {
+         return 0;
+      }
+      
+      switch(nameHash) {
+      case HashName("MysticShot"):
+         return new MysticShot(owner, slot, data);
+      }
+      
+      return 0;
+   }
+
+
+};
+
+#endif
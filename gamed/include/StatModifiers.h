@@ -0,0 +1,122 @@
+#ifndef _STAT_MODIFIERS_H
+#define _STAT_MODIFIERS_H
+
+#include <map>
+
+#include "stdafx.h"
+#include "Stats.h"
+#include "TimerWheel.h"
+
+enum ModifierType : uint8 {
+   MODIFIER_FLAT,
+   MODIFIER_PERCENT,
+   MODIFIER_OVERRIDE
+};
+
+/**
+ * Logical stats that items, buffs and level-ups can modify.
+ * Each attribute feeds one or more replicated Stats fields.
+ */
+enum StatAttribute : uint8 {
+   ATTR_ATTACK_DAMAGE,
+   ATTR_ABILITY_POWER,
+   ATTR_ATTACK_SPEED,
+   ATTR_CRIT_CHANCE,
+   ATTR_ARMOR,
+   ATTR_MAGIC_ARMOR,
+   ATTR_HP5,
+   ATTR_MP5,
+   ATTR_RANGE,
+   ATTR_COOLDOWN_REDUCTION,
+   ATTR_MAX_HEALTH,
+   ATTR_MOVEMENT_SPEED,
+   ATTR_COUNT
+};
+
+class SnapshotReader;
+class SnapshotWriter;
+class StatModifiers;
+
+/**
+ * Removes a timed modifier when it fires
+ */
+class ModifierExpiry : public Timer {
+public:
+   StatModifiers* owner;
+   uint32 handle;
+
+protected:
+   void onTimer();
+};
+
+struct StatModifier {
+   uint32 source;
+   StatAttribute attribute;
+   ModifierType type;
+   float value;
+   ModifierExpiry expiry; // Not scheduled if permanent
+};
+
+class StatModifiers {
+
+private:
+   Stats* stats;
+   TimerWheel* timers;
+
+   std::map<uint32, StatModifier> modifiers;
+   uint32 nextHandle;
+
+   /**
+    * Per attribute aggregates, kept up to date on every add/remove so that
+    * recomputing an attribute never has to walk the modifier list
+    */
+   float base[ATTR_COUNT];
+   float flat[ATTR_COUNT];
+   float percent[ATTR_COUNT];
+   float overrideValue[ATTR_COUNT];
+   uint8 overrideCount[ATTR_COUNT];
+
+   uint32 knownBase;
+   uint32 dirty;
+
+   void captureBase(StatAttribute attr);
+   void recompute(StatAttribute attr);
+   void refreshOverride(StatAttribute attr);
+   void writeField(uint8 blockId, uint32 field, float value);
+
+public:
+   StatModifiers(Stats* stats, TimerWheel* timers);
+
+   /**
+    * Adds a modifier to an attribute
+    * @param source the item, buff or spell id applying it, for bulk removal
+    * @param duration lifetime in milliseconds, 0 for a permanent modifier
+    * @return a handle to remove the modifier with
+    */
+   uint32 addModifier(uint32 source, StatAttribute attr, ModifierType type, float value, uint32 duration = 0);
+   bool removeModifier(uint32 handle);
+   void removeModifiersFrom(uint32 source);
+
+   /**
+    * Sets the unmodified value of an attribute, eg. on level up
+    */
+   void setBaseValue(StatAttribute attr, float value);
+   float getBaseValue(StatAttribute attr) const;
+
+   /**
+    * @return the attribute's value with every modifier applied
+    */
+   float getTotal(StatAttribute attr) const;
+
+   /**
+    * Recomputes the attributes whose inputs changed. Only the Stats fields
+    * that actually end up with a new value get marked as updated.
+    */
+   void update();
+
+   void save(SnapshotWriter& s) const;
+   void load(SnapshotReader& s);
+
+};
+
+#endif
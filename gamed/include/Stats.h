@@ -1,11 +1,12 @@
 #ifndef __H_STATS
 #define __H_STATS
 
-#include <map>
-
 #include "stdafx.h"
 #include "common.h"
 
+class SnapshotReader;
+class SnapshotWriter;
+
 enum FieldMaskOne : uint32
 {
    FM1_Gold        = 0x00000001,
@@ -56,103 +57,176 @@ enum FieldMaskFive : uint32
 
 class Stats {
 
-private:
-   std::map<uint32, float> stats[5];
-   std::multimap<uint8, uint32> updatedStats;
+protected:
+   float stats[5][32];
+   uint32 updatedStats[5];
    
+   uint32 maxHealthField;
+
+   /**
+    * Block index (0-4) of a master mask value such as MM_Two
+    */
+   static int getBlockIndex(uint8 blockId) {
+      return __builtin_ctz(blockId);
+   }
+
 public:
-   float getStat(uint8 blockId, uint32 stat) const;
-   void setStat(uint8 blockId, uint32 stat, float value);
+   Stats() : maxHealthField(FM4_MaxHp) {
+      memset(stats, 0, sizeof(stats));
+      memset(updatedStats, 0, sizeof(updatedStats));
+   }
 
-   const std::multimap<uint8, uint32>& getUpdatedStats() const { return updatedStats; }
-   void clearUpdatedStats() { updatedStats.clear(); }
+   float getStat(uint8 blockId, uint32 stat) const {
+      return stats[getBlockIndex(blockId)][__builtin_ctz(stat)];
+   }
+
+   void setStat(uint8 blockId, uint32 stat, float value) {
+      int block = getBlockIndex(blockId);
+      stats[block][__builtin_ctz(stat)] = value;
+      updatedStats[block] |= stat;
+   }
+
+   /**
+    * @return the fields of the given block that changed since the last clear
+    */
+   uint32 getUpdatedMask(uint8 blockId) const { return updatedStats[getBlockIndex(blockId)]; }
+   
+   /**
+    * @return the master mask of the blocks holding at least one updated field
+    */
+   uint8 getUpdatedMasterMask() const;
+   
+   bool hasUpdatedStats() const { return getUpdatedMasterMask() != 0; }
+   void save(SnapshotWriter& s) const;
+   void load(SnapshotReader& s);
+   void clearUpdatedStats() { memset(updatedStats, 0, sizeof(updatedStats)); }
+   
+   /**
+    * Marks every field with a value as changed, for peers that need them all again
+    */
+   void markAllUpdated();
 
-   virtual float getBaseAd() const {
+   float getBaseAd() const {
       return getStat(MM_Two, FM2_Base_Ad);
    }
    
-   virtual float getBaseAp() const {
+   float getBaseAp() const {
       return getStat(MM_Two, FM2_Base_Ap);
    }
    
-   virtual float getCritChance() const {
+   /**
+    * Base AD with the flat then percentage bonuses
+    */
+   float getTotalAd() const {
+      return (getBaseAd() + getStat(MM_Two, FM2_Bonus_Ad_Flat)) * (1 + getStat(MM_Two, FM2_Bonus_Ad_Pct));
+   }
+   
+   /**
+    * Multiplier applied to the base attack speed, units without bonus start at 0
+    */
+   float getAttackSpeedMultiplier() const {
+      float multiplier = getStat(MM_Two, FM2_Bonus_Ats);
+      return multiplier > 0 ? multiplier : 1;
+   }
+   
+   float getArmorPen() const {
+      return getStat(MM_Three, FM3_Armor_Pen);
+   }
+   
+   float getMagicPen() const {
+      return getStat(MM_Three, FM3_Magic_Pen);
+   }
+   
+   float getCritChance() const {
       return getStat(MM_Two, FM2_Crit_Chance);
    }
    
-   virtual float getArmor() const {
+   float getArmor() const {
       return getStat(MM_Two, FM2_Armor);
    }
    
-   virtual float getMagicArmor() const {
+   float getMagicArmor() const {
       return getStat(MM_Two, FM2_Magic_Armor);
    }
    
-   virtual float getRange() const {
+   float getRange() const {
       return getStat(MM_Two, FM2_Range);
    }
    
-   virtual float getCurrentHealth() const {
+   float getCurrentHealth() const {
       return getStat(MM_Four, FM4_CurrentHp);
    }
    
-   virtual float getCurrentMana() const {
+   float getCurrentMana() const {
       return getStat(MM_Four, FM4_CurrentMana);
    }
 
-   virtual float getMaxHealth() const {
-      return getStat(MM_Four, FM4_MaxHp);
+   float getMaxHealth() const {
+      return getStat(MM_Four, maxHealthField);
    }
    
-   virtual float getMovementSpeed() const {
+   float getMovementSpeed() const {
       return getStat(MM_Four, FM4_Speed);
    }
 
 
-   virtual void setBaseAd(float ad) {
+   void setBaseAd(float ad) {
       setStat(MM_Two, FM2_Base_Ad, ad);
    }
    
-   virtual void setRange(float range) {
+   void setRange(float range) {
       setStat(MM_Two, FM2_Range, range);
    }
    
-   virtual void setArmor(float armor) {
+   void setArmor(float armor) {
       setStat(MM_Two, FM2_Armor, armor);
    }
    
-   virtual void setMagicArmor(float armor) {
+   void setMagicArmor(float armor) {
       setStat(MM_Two, FM2_Magic_Armor, armor);
    }
    
-   virtual void setHp5(float hp5) {
+   void setHp5(float hp5) {
       setStat(MM_Two, FM2_Hp5, hp5);
    }
    
-   virtual void setMp5(float mp5) {
+   void setMp5(float mp5) {
       setStat(MM_Two, FM2_Mp5, mp5);
    }
    
-   virtual void setCurrentHealth(float health) {
+   void setCurrentHealth(float health) {
       setStat(MM_Four, FM4_CurrentHp, health);
    }
    
-   virtual void setCurrentMana(float mana) {
+   /**
+    * Health lost to damage goes to the clients in its own SetHealth, not
+    * in the stats updates, so the field isn't marked as changed
+    */
+   void setDamagedHealth(float health) {
+      stats[getBlockIndex(MM_Four)][__builtin_ctz(FM4_CurrentHp)] = health;
+   }
+   
+   void setCurrentMana(float mana) {
       setStat(MM_Four, FM4_CurrentMana, mana);
    }
    
-   virtual void setMaxMana(float mana) {
+   void setMaxMana(float mana) {
       setStat(MM_Four, FM4_MaxMp, mana);
    }
 
-   virtual void setMaxHealth(float health) {
-      setStat(MM_Four, FM4_MaxHp, health);
+   void setMaxHealth(float health) {
+      setStat(MM_Four, maxHealthField, health);
    }
    
-   virtual void setMovementSpeed(float speed) {
+   void setMovementSpeed(float speed) {
       setStat(MM_Four, FM4_Speed, speed);
    }
    
-   virtual void setGold(float gold) {
+   float getGold() const {
+      return getStat(MM_One, FM1_Gold);
+   }
+   
+   void setGold(float gold) {
       setStat(MM_One, FM1_Gold, gold);
    }
 
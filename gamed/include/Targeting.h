@@ -0,0 +1,113 @@
+/**
+ * Target acquisition queries on top of the spatial index:
+ * "the k best enemies of these kinds within this radius".
+ * AI agents submit their queries during the tick, and they are all answered
+ * in one pass against the same index.
+ */
+
+#ifndef _TARGETING_H
+#define _TARGETING_H
+
+#include <vector>
+
+#include "stdafx.h"
+#include "JobSystem.h"
+#include "SpatialIndex.h"
+
+#define TARGET_MAX_RESULTS 8
+
+class Unit;
+
+struct TargetCandidate {
+   Unit* unit;
+   float distanceSq;
+   uint8 kind;
+};
+
+/**
+ * Returns true if a should be picked before b
+ */
+typedef bool (*TargetPriority)(const TargetCandidate& a, const TargetCandidate& b);
+
+bool PriorityClosest(const TargetCandidate& a, const TargetCandidate& b);
+
+/**
+ * Minions first, then turrets, then champions, closest first within a kind.
+ * This is the default rule for minions and turrets.
+ */
+bool PriorityLaneRules(const TargetCandidate& a, const TargetCandidate& b);
+
+struct TargetQuery {
+   float x, y;
+   float radius;
+   uint32 side;              // Side of the unit looking for targets
+   bool enemies;             // Look for enemies of side, or allies
+   uint8 kinds;              // UnitKind mask
+   uint8 maxResults;
+   TargetPriority priority;
+   const Unit* exclude;
+
+   TargetQuery(float x, float y, float radius, uint32 side, uint8 kinds, uint8 maxResults = 1, TargetPriority priority = PriorityClosest)
+      : x(x), y(y), radius(radius), side(side), enemies(true), kinds(kinds), maxResults(maxResults), priority(priority), exclude(0) { }
+};
+
+/**
+ * Receives the answer to a submitted query, best target first
+ */
+class TargetListener {
+public:
+   virtual ~TargetListener() { }
+   virtual void onTargetsFound(Unit** targets, uint32 count) = 0;
+};
+
+class Targeting {
+
+private:
+   SpatialIndex index;
+
+   struct PendingQuery {
+      TargetQuery query;
+      TargetListener* listener;
+   };
+
+   struct QueryResult {
+      Unit* targets[TARGET_MAX_RESULTS];
+      uint32 count;
+   };
+
+   std::vector<PendingQuery> pending;
+   std::vector<QueryResult> results;
+   std::vector<std::vector<TargetCandidate> > candidates; // Scratch space of each worker
+
+   uint32 answer(const TargetQuery& query, Unit** out, std::vector<TargetCandidate>& scratch) const;
+
+public:
+   SpatialIndex& getIndex() { return index; }
+
+   /**
+    * Answers a query right away against the current index
+    * @param out receives at most query.maxResults units
+    * @return the number of units found
+    */
+   uint32 query(const TargetQuery& query, Unit** out);
+
+   /**
+    * Queues a query, answered on the next process()
+    */
+   void submit(const TargetQuery& query, TargetListener* listener);
+
+   /**
+    * Drops the queued queries of a listener about to be destroyed
+    */
+   void cancel(TargetListener* listener);
+
+   /**
+    * Answers every queued query, once per tick after the index is rebuilt.
+    * The queries are answered in parallel, then the listeners are called
+    * one by one in the order the queries were submitted.
+    */
+   void process(JobSystem& jobs);
+
+};
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * Hierarchical timer wheel driving every timed event of a game.
+ * Scheduling and cancelling are O(1), and advancing the clock only costs
+ * the timers that actually expire, instead of polling every object.
+ */
+
+#ifndef _TIMER_WHEEL_H
+#define _TIMER_WHEEL_H
+
+#include "stdafx.h"
+
+#define TIMER_ROOT_BITS 8
+#define TIMER_LEVEL_BITS 6
+#define TIMER_LEVELS 4
+#define TIMER_ROOT_SIZE (1 << TIMER_ROOT_BITS)
+#define TIMER_LEVEL_SIZE (1 << TIMER_LEVEL_BITS)
+#define TIMER_MAX_DELAY ((1ULL << (TIMER_ROOT_BITS + (TIMER_LEVELS-1)*TIMER_LEVEL_BITS)) - 1)
+
+class TimerWheel;
+
+struct TimerNode {
+   TimerNode* next;
+   TimerNode* prev;
+
+   TimerNode() : next(0), prev(0) { }
+};
+
+/**
+ * Something to be called back once a delay has elapsed.
+ * The timer is embedded in its owner, the wheel never allocates.
+ */
+class Timer : private TimerNode {
+   friend class TimerWheel;
+
+private:
+   TimerWheel* wheel;
+   uint64 expires;
+   uint8 level;
+
+public:
+   Timer() : wheel(0), expires(0), level(0) { }
+   Timer(const Timer&) = delete;
+   Timer& operator=(const Timer&) = delete;
+   virtual ~Timer() { cancel(); }
+
+   bool isScheduled() const { return wheel != 0; }
+   void cancel();
+
+   /**
+    * @return the milliseconds left before the timer fires, 0 if not scheduled
+    */
+   uint32 getRemaining() const;
+
+protected:
+   virtual void onTimer() = 0;
+};
+
+class TimerWheel {
+   friend class Timer;
+
+private:
+   TimerNode root[TIMER_ROOT_SIZE];
+   TimerNode levels[TIMER_LEVELS-1][TIMER_LEVEL_SIZE];
+
+   uint64 time;       // Current game time, in milliseconds
+   uint64 tick;       // Next millisecond to process
+   uint32 rootCount;  // Timers in the root level, to skip empty stretches
+   uint32 count;
+
+   void place(Timer* t);
+   void unlink(Timer* t);
+   void cascade(int level);
+
+public:
+   TimerWheel();
+
+   /**
+    * Schedules t to fire after delay milliseconds, rescheduling it if needed
+    */
+   void schedule(Timer* t, uint32 delay);
+   void cancel(Timer* t);
+
+   /**
+    * Advances the game clock, firing every timer that expires on the way
+    */
+   void update(unsigned int diff);
+
+   /**
+    * Moves the clock of an empty wheel, when restoring a game
+    * @return false if timers are already pending
+    */
+   bool setTime(uint64 time);
+
+   uint64 getTime() const { return time; }
+   uint32 getPendingCount() const { return count; }
+};
+
+#endif
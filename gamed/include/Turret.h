@@ -0,0 +1,61 @@
+#ifndef _TURRET_H
+#define _TURRET_H
+
+#include <string>
+
+#include "Unit.h"
+#include "Targeting.h"
+#include "TimerWheel.h"
+
+#define TURRET_COUNT 24
+#define TURRET_RANGE 775.f
+#define TURRET_ATTACK_SPEED 0.83f
+#define TURRET_SCAN_DELAY 250     // Milliseconds between two checks of the target
+
+struct TurretInfo {
+   const char* name;
+   float x, y;
+   uint32 side;
+   float health;
+};
+
+/**
+ * Static structure, built once with the map and never moving.
+ * Turrets live in their own array instead of the map's objects, so the
+ * per-tick update loop never visits them: they only check their target
+ * when their timer fires, and leave the shooting to their auto attack.
+ */
+class Turret : public Unit, public Timer, public TargetListener {
+
+private:
+   std::string name;
+   uint32 targetId;
+
+   void attack(Unit* target);
+
+protected:
+   void onTimer();
+
+public:
+   Turret(Map* map, uint32 id, const TurretInfo& info);
+   ~Turret();
+
+   const std::string& getName() const { return name; }
+   UnitKind getKind() const { return UNIT_TURRET; }
+   float getMoveSpeed() const { return 0; }
+   void die(Unit* killer);
+
+   /**
+    * Starts looking for targets, called when the game starts
+    */
+   void activate();
+   void onTargetsFound(Unit** targets, uint32 count);
+   
+   void save(SnapshotWriter& s) const;
+   void load(SnapshotReader& s);
+
+   static const TurretInfo turretInfos[TURRET_COUNT];
+
+};
+
+#endif
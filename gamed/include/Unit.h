@@ -1,17 +1,17 @@
 #ifndef _UNIT_H
 #define _UNIT_H
 
+#include "AutoAttack.h"
+#include "DamageQueue.h"
 #include "Object.h"
 #include "Stats.h"
+#include "StatModifiers.h"
 
-enum DamageType {
-   DAMAGE_TYPE_PHYSICAL,
-   DAMAGE_TYPE_MAGICAL
-};
-
-enum DamageSource {
-   DAMAGE_SOURCE_ATTACK,
-   DAMAGE_SOURCE_SPELL
+enum UnitKind : uint8 {
+   UNIT_CHAMPION = 0x01,
+   UNIT_MINION   = 0x02,
+   UNIT_TURRET   = 0x04,
+   UNIT_ANY      = 0xFF
 };
 
 class AI;
@@ -20,16 +20,36 @@ class Unit : public Object {
 
 protected:
    Stats* stats;
+   StatModifiers modifiers;
    AI* ai;
+   AutoAttack autoAttack;
 
 public:
-   Unit(Map* map, uint32 id, Stats* stats, float x = 0, float y = 0, AI* ai = 0) : Object(map, id, x, y, 40, 40), stats(stats), ai(ai) { }
+   Unit(Map* map, uint32 id, Stats* stats, float x = 0, float y = 0, AI* ai = 0);
    virtual ~Unit();
    Stats& getStats() { return *stats; }
+   StatModifiers& getModifiers() { return modifiers; }
+   AI* getAI() { return ai; }
+   AutoAttack& getAutoAttack() { return autoAttack; }
+   virtual void integrate(unsigned int diff);
    virtual void update(unsigned int diff);
    virtual float getMoveSpeed() const { return stats->getMovementSpeed(); }
+   virtual UnitKind getKind() const = 0;
    
+   virtual void save(SnapshotWriter& s) const;
+   virtual void load(SnapshotReader& s);
+   
+   /**
+    * Queues damage on target, it is mitigated and applied at the end of the tick
+    */
    void dealDamageTo(Unit* target, float damage, DamageType type, DamageSource source);
+   
+   /**
+    * Called once when the unit's health reaches 0
+    * @param killer the unit that dealt the last hit, if it's still around
+    */
+   virtual void die(Unit* killer);
+   virtual void onKill(Unit*) { }
 
 };
 
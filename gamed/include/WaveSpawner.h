@@ -0,0 +1,47 @@
+#ifndef _WAVE_SPAWNER_H
+#define _WAVE_SPAWNER_H
+
+#include "stdafx.h"
+#include "Minion.h"
+#include "TimerWheel.h"
+
+#define WAVE_FIRST_DELAY 90000   // Milliseconds between the game start and the first wave
+#define WAVE_INTERVAL 30000      // Milliseconds between the start of two waves
+#define WAVE_SPAWN_INTERVAL 800  // Milliseconds between two minions of a wave
+#define WAVE_CANNON_EVERY 3      // Every third wave brings a cannon minion
+
+class Map;
+class SnapshotReader;
+class SnapshotWriter;
+
+/**
+ * Spawns a wave of minions at every lane spawn point, minion by minion,
+ * on a timer: 3 melee, a cannon every few waves, then 3 casters.
+ */
+class WaveSpawner : public Timer {
+
+private:
+   Map* map;
+   uint32 waveNo;
+   uint8 spawned;
+
+   MinionSpawnType getNextType() const;
+   uint8 getWaveSize() const;
+
+protected:
+   void onTimer();
+
+public:
+   WaveSpawner(Map* map) : map(map), waveNo(0), spawned(0) { }
+
+   /**
+    * Schedules the first wave, does nothing if the waves already started
+    */
+   void start();
+   
+   void save(SnapshotWriter& s) const;
+   void load(SnapshotReader& s);
+
+};
+
+#endif
@@ -0,0 +1,94 @@
+/**
+ * Read-only copy of the replicated state of a tick: positions, waypoints,
+ * health and the stats that changed.
+ * The map captures a frame at the end of every tick and publishes it, then
+ * packets, spectators and metrics are built from the frame instead of the
+ * live objects, so they can run on other threads while the next tick is
+ * being simulated.
+ */
+
+#ifndef _WORLD_STATE_H
+#define _WORLD_STATE_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "stdafx.h"
+#include "Object.h"
+
+enum UnitViewFlags : uint8 {
+   VIEW_MOVED = 0x01,   // Got new waypoints this tick
+   VIEW_STATS = 0x02,   // Some stats changed this tick
+   VIEW_REMOVED = 0x04, // Removed from the map this tick, last frame it appears in
+   VIEW_UNIT = 0x08     // Has stats and health, projectiles don't
+};
+
+/**
+ * State of one object. Its waypoints and changed stats are ranges of the
+ * frame's shared arrays, so capturing a frame doesn't allocate.
+ */
+struct UnitView {
+   uint32 netId;
+   float x, y;
+   uint32 side;
+   float health, maxHealth;
+   uint32 firstWaypoint;
+   uint16 waypointCount;
+   uint8 flags;
+   uint8 statMasterMask; // Blocks with changed stats, one mask per block in statMasks
+   uint32 firstStatMask;
+   uint32 firstStatValue;
+};
+
+struct WorldFrame {
+   uint64 time;          // Game time at the end of the tick, in milliseconds
+   std::vector<UnitView> units;
+   std::vector<MovementVector> waypoints;
+   std::vector<uint32> statMasks;
+   std::vector<float> statValues;
+
+   WorldFrame() : time(0) { }
+
+   void clear();
+
+   /**
+    * Copies the state of an object, and clears its movement and stats flags
+    */
+   void capture(Object* o, bool removed);
+};
+
+/**
+ * Frames live as long as someone reads them. The simulation writes into a
+ * frame nobody holds anymore, usually the one from two ticks ago, and only
+ * allocates a new one when a reader is still behind.
+ */
+class WorldState {
+
+private:
+   std::mutex lock;
+   std::vector<std::shared_ptr<WorldFrame> > frames;
+   std::shared_ptr<WorldFrame> current;   // Latest published frame
+   std::shared_ptr<WorldFrame> writing;
+
+public:
+   WorldState() { }
+
+   /**
+    * @return a cleared frame for the simulation to fill
+    */
+   WorldFrame& beginFrame(uint64 time);
+
+   /**
+    * Makes the frame being written the latest one
+    */
+   void publish();
+
+   /**
+    * @return the latest published frame, valid for as long as it's held. Thread safe.
+    */
+   std::shared_ptr<const WorldFrame> acquire();
+
+};
+
+#endif
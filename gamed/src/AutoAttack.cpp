@@ -0,0 +1,110 @@
+#include "AutoAttack.h"
+#include "Unit.h"
+#include "Map.h"
+#include "Snapshot.h"
+
+Unit* AutoAttack::getTargetUnit() const {
+   if(!targetId) {
+      return 0;
+   }
+
+   Unit* u = dynamic_cast<Unit*>(owner->getMap()->getObjectById(targetId));
+   if(!u || u->isToRemove() || u->getStats().getCurrentHealth() <= 0) {
+      return 0;
+   }
+
+   return u;
+}
+
+bool AutoAttack::isInRange(Unit* target) const {
+   return owner->distanceWith(target) <= owner->getStats().getRange() + ATTACK_RANGE_SLACK;
+}
+
+uint32 AutoAttack::getInterval() const {
+   return 1000.f / (baseSpeed * owner->getStats().getAttackSpeedMultiplier());
+}
+
+void AutoAttack::start(Unit* target) {
+   if(!target || target == owner) {
+      stop();
+      return;
+   }
+
+   targetId = target->getNetId();
+
+   // A cooldown in progress starts the next windup by itself
+   if(state == ATTACK_IDLE) {
+      state = ATTACK_WINDUP;
+      owner->getMap()->getTimers().schedule(this, getInterval()*ATTACK_WINDUP_RATIO);
+   }
+}
+
+void AutoAttack::stop() {
+   targetId = 0;
+
+   // Cancelling during the cooldown would allow attacking again too early
+   if(state == ATTACK_WINDUP) {
+      cancel();
+      state = ATTACK_IDLE;
+   }
+}
+
+void AutoAttack::fire(Unit* target) {
+   Map* map = owner->getMap();
+   float damage = owner->getStats().getTotalAd();
+
+   map->addAttackEvent(owner, target);
+
+   if(owner->getStats().getRange() < ATTACK_MELEE_RANGE || !map->getMissiles().launch(owner, target, damage, missileSpeed)) {
+      owner->dealDamageTo(target, damage, DAMAGE_TYPE_PHYSICAL, DAMAGE_SOURCE_ATTACK);
+   }
+}
+
+void AutoAttack::onTimer() {
+   Unit* target = getTargetUnit();
+   TimerWheel& timers = owner->getMap()->getTimers();
+   uint32 interval = getInterval();
+   uint32 windup = interval*ATTACK_WINDUP_RATIO;
+
+   switch(state) {
+   case ATTACK_IDLE:
+      return;
+   case ATTACK_WINDUP:
+      if(!target) {
+         targetId = 0;
+         state = ATTACK_IDLE;
+      } else if(!isInRange(target)) {
+         timers.schedule(this, ATTACK_RETRY_DELAY);
+      } else {
+         fire(target);
+         state = ATTACK_COOLDOWN;
+         timers.schedule(this, interval - windup);
+      }
+      break;
+   case ATTACK_COOLDOWN:
+      if(target) {
+         state = ATTACK_WINDUP;
+         timers.schedule(this, windup);
+      } else {
+         targetId = 0;
+         state = ATTACK_IDLE;
+      }
+      break;
+   }
+}
+
+void AutoAttack::save(SnapshotWriter& s) const {
+   s.put(targetId);
+   s.put(baseSpeed);
+   s.put(missileSpeed);
+   s.put(state);
+   s.putTimer(*this);
+}
+
+void AutoAttack::load(SnapshotReader& s) {
+   targetId = s.get<uint32>();
+   baseSpeed = s.get<float>();
+   missileSpeed = s.get<float>();
+   state = s.get<AttackState>();
+   s.getTimer(*this, owner->getMap()->getTimers());
+}
@@ -1,8 +1,39 @@
 #include "Champion.h"
+#include "GameData.h"
+#include "Snapshot.h"
+#include "SpellFactory.h"
 
-Champion::Champion(const std::string& type, Map* map, uint32 id) : Unit::Unit(map, id, new Stats()), type(type), skillPoints(1), level(1)  {
-   stats->setCurrentHealth(666.0f);
-   stats->setMaxHealth(1337.0f);
+Champion::Champion(const std::string& type, Map* map, uint32 id) : Unit::Unit(map, id, new Stats()), type(type), skillPoints(1), level(1), viewDelay(0)  {
+   const ChampionData* data = GameData::getInstance().getChampion(type);
+   
+   if(data) {
+      stats->setCurrentHealth(data->health);
+      stats->setMaxHealth(data->health);
+      stats->setCurrentMana(data->mana);
+      stats->setMaxMana(data->mana);
+      stats->setBaseAd(data->attackDamage);
+      stats->setRange(data->range);
+      stats->setMovementSpeed(data->moveSpeed);
+      stats->setArmor(data->armor);
+      stats->setMagicArmor(data->magicArmor);
+      stats->setHp5(data->hp5);
+      stats->setMp5(data->mp5);
+      
+      // Slots stay in order, so a spell without a script ends the list
+      for(uint8 slot = 0; slot < 4 && data->spells[slot]; ++slot) {
+         Spell* s = SpellFactory::getSpellFromHash(data->spells[slot], this, slot);
+         if(!s) {
+            printf("No script for spell %u of champion %s\n", slot, type.c_str());
+            break;
+         }
+         spells.push_back(s);
+      }
+   } else {
+      printf("No data for champion %s\n", type.c_str());
+      stats->setCurrentHealth(666.0f);
+      stats->setMaxHealth(1337.0f);
+   }
+   
    stats->setGold(475.0f);
 }
 
@@ -37,10 +68,46 @@ Spell* Champion::levelUpSpell(uint8 slot) {
    return spells[slot];
 }
 
-void Champion::update(unsigned int diff) {
-   Unit::update(diff);
-   
-   for(Spell* s : spells) {
-      s->update(diff);
+void Champion::onKill(Unit* victim) {
+   switch(victim->getKind()) {
+   case UNIT_MINION:
+      stats->setGold(stats->getGold() + 20.f);
+      break;
+   case UNIT_TURRET:
+      stats->setGold(stats->getGold() + 150.f);
+      break;
+   case UNIT_CHAMPION:
+      stats->setGold(stats->getGold() + 300.f);
+      break;
+   default:
+      break;
+   }
+}
+
+void Champion::save(SnapshotWriter& s) const {
+   Unit::save(s);
+   s.put(skillPoints);
+   s.put(level);
+   s.put(xp);
+   s.put((uint8)spells.size());
+   for(Spell* spell : spells) {
+      spell->save(s);
    }
-}
\ No newline at end of file
+}
+
+void Champion::load(SnapshotReader& s) {
+   Unit::load(s);
+   skillPoints = s.get<uint8>();
+   level = s.get<uint8>();
+   xp = s.get<float>();
+
+   uint8 count = s.get<uint8>();
+   if(count != spells.size()) {
+      printf("Snapshot has %u spells for %s, expected %u\n", count, type.c_str(), (uint32)spells.size());
+      s.fail();
+      return;
+   }
+   for(Spell* spell : spells) {
+      spell->load(s);
+   }
+}
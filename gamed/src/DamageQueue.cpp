@@ -0,0 +1,86 @@
+#include "DamageQueue.h"
+#include "AI.h"
+#include "Map.h"
+
+#include <algorithm>
+
+using namespace std;
+
+static bool compareTargets(const DamageEvent& a, const DamageEvent& b) {
+   return a.targetId < b.targetId;
+}
+
+void DamageQueue::push(Unit* source, Unit* target, float amount, DamageType type, DamageSource damageSource) {
+   if(amount <= 0) {
+      return;
+   }
+
+   DamageEvent e = { source ? source->getNetId() : 0, target->getNetId(), amount, type, damageSource };
+   events.push_back(e);
+}
+
+/**
+ * 100 resistance halves the damage, negative resistance amplifies it
+ */
+float DamageQueue::mitigate(float amount, float resistance) {
+   if(resistance >= 0) {
+      return amount * 100 / (100 + resistance);
+   }
+
+   return amount * (2 - 100 / (100 - resistance));
+}
+
+void DamageQueue::process(vector<Unit*>& damaged) {
+   // Stable, so a target takes its hits in the order they were dealt
+   stable_sort(events.begin(), events.end(), compareTargets);
+
+   for(uint32 first = 0; first < events.size();) {
+      uint32 last = first;
+      while(last < events.size() && events[last].targetId == events[first].targetId) {
+         ++last;
+      }
+
+      Unit* target = dynamic_cast<Unit*>(map->getObjectById(events[first].targetId));
+      if(!target || target->getStats().getCurrentHealth() <= 0) {
+         first = last;
+         continue;
+      }
+
+      Stats& stats = target->getStats();
+      float health = stats.getCurrentHealth();
+
+      for(uint32 i = first; i < last && health > 0; ++i) {
+         const DamageEvent& e = events[i];
+         Unit* source = e.sourceId ? dynamic_cast<Unit*>(map->getObjectById(e.sourceId)) : 0;
+
+         float resistance = (e.type == DAMAGE_TYPE_PHYSICAL) ? stats.getArmor() : stats.getMagicArmor();
+         if(source) {
+            resistance -= (e.type == DAMAGE_TYPE_PHYSICAL) ? source->getStats().getArmorPen() : source->getStats().getMagicPen();
+         }
+
+         float amount = mitigate(e.amount, resistance);
+         health = max(0.f, health - amount);
+
+         if(target->getAI()) {
+            target->getAI()->onDamageTaken(source, amount);
+         }
+
+         if(health <= 0) {
+            stats.setDamagedHealth(0);
+            target->die(source);
+            if(source) {
+               source->onKill(target);
+            }
+         }
+      }
+
+      if(health > 0) {
+         stats.setDamagedHealth(health);
+      }
+
+      damaged.push_back(target);
+      first = last;
+   }
+
+   events.clear();
+}
@@ -0,0 +1,284 @@
+#include "FlightRecorder.h"
+
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+
+#if defined(WIN32) || defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#define FLIGHT_CRASH_STACK 65536
+
+static volatile sig_atomic_t dumpRequested = 0;
+static char crashFile[64];
+
+/* Dumps go through plain file descriptors, stdio isn't safe in a signal handler */
+#if defined(WIN32) || defined(_WIN32)
+static int openDump(const char* fileName) {
+   return _open(fileName, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+}
+
+static int writeDump(int fd, const uint8* data, uint32 length) {
+   return _write(fd, data, length);
+}
+
+static int closeDump(int fd) {
+   return _close(fd);
+}
+#else
+static int openDump(const char* fileName) {
+   return open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+}
+
+static int writeDump(int fd, const uint8* data, uint32 length) {
+   return write(fd, data, length);
+}
+
+static int closeDump(int fd) {
+   return close(fd);
+}
+#endif
+
+FlightRecorder& FlightRecorder::getInstance() {
+   static FlightRecorder instance;
+   return instance;
+}
+
+FlightRecorder::FlightRecorder() : slots(new FlightSlot[FLIGHT_SLOTS]()), next(0), dumping(false), start(std::chrono::steady_clock::now()),
+                                   startTime(time(0)), lastSlowDump(0) {
+}
+
+void FlightRecorder::recordTick(uint32 tick, uint32 durationUs) {
+   record(FLIGHT_TICK, tick, 0, 0, durationUs);
+   if(durationUs < FLIGHT_SLOW_TICK_US) {
+      return;
+   }
+
+   uint64 time = now();
+   if(lastSlowDump && time - lastSlowDump < FLIGHT_WINDOW_S*1000000ULL) {
+      return;
+   }
+   lastSlowDump = time;
+
+   char fileName[64];
+   sprintf(fileName, "flight-slow-%u.iwf", tick);
+   if(dump(fileName)) {
+      printf("Tick %u took %.1f ms, flight recorder written to %s\n", tick, durationUs/1000.0, fileName);
+   }
+}
+
+void FlightRecorder::poll(uint32 tick) {
+   if(!dumpRequested) {
+      return;
+   }
+   dumpRequested = 0;
+
+   char fileName[64];
+   sprintf(fileName, "flight-signal-%u.iwf", tick);
+   if(dump(fileName)) {
+      printf("Flight recorder written to %s\n", fileName);
+   }
+}
+
+#if !defined(WIN32) && !defined(_WIN32)
+static FlightRecorder* crashRecorder = 0; // Set before the handlers, so they never construct it
+
+static void onDumpSignal(int) {
+   dumpRequested = 1;
+}
+
+/**
+ * The handler is reset on entry, raising the signal again ends the process as it would have
+ */
+static void onCrash(int signal) {
+   if(crashRecorder) {
+      crashRecorder->dump(crashFile);
+   }
+   raise(signal);
+}
+#endif
+
+void FlightRecorder::installHandlers() {
+#if !defined(WIN32) && !defined(_WIN32)
+   crashRecorder = this;
+   snprintf(crashFile, sizeof(crashFile), "flight-crash-%d.iwf", (int)getpid());
+
+   // A stack overflow leaves no room for the handler on the thread's stack
+   static uint8 crashStack[FLIGHT_CRASH_STACK];
+   stack_t stack;
+   stack.ss_sp = crashStack;
+   stack.ss_size = sizeof(crashStack);
+   stack.ss_flags = 0;
+   sigaltstack(&stack, 0);
+
+   struct sigaction action;
+   memset(&action, 0, sizeof(action));
+   sigemptyset(&action.sa_mask);
+   action.sa_handler = onCrash;
+   action.sa_flags = SA_ONSTACK | SA_RESETHAND;
+
+   int crashes[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+   for(int signal : crashes) {
+      sigaction(signal, &action, 0);
+   }
+
+   action.sa_handler = onDumpSignal;
+   action.sa_flags = SA_RESTART;
+   sigaction(SIGUSR1, &action, 0);
+#endif
+}
+
+static bool writeAll(int fd, const uint8* data, uint32 length) {
+   while(length) {
+      int written = writeDump(fd, data, length);
+      if(written <= 0) {
+         return false;
+      }
+      data += written;
+      length -= written;
+   }
+   return true;
+}
+
+bool FlightRecorder::dump(const char* fileName) {
+   bool expected = false;
+   if(!dumping.compare_exchange_strong(expected, true)) {
+      return false;
+   }
+
+   int fd = openDump(fileName);
+   if(fd < 0) {
+      dumping.store(false);
+      return false;
+   }
+
+   uint64 last = next.load(std::memory_order_acquire);
+   uint64 first = last > FLIGHT_SLOTS ? last - FLIGHT_SLOTS : 0;
+   uint64 time = now();
+   uint64 oldest = time > FLIGHT_WINDOW_S*1000000ULL ? time - FLIGHT_WINDOW_S*1000000ULL : 0;
+
+   FlightHeader header;
+   header.magic = FLIGHT_MAGIC;
+   header.version = FLIGHT_VERSION;
+   header.slotData = FLIGHT_SLOT_DATA;
+   header.startTime = startTime;
+   header.events = last;
+   memcpy(dumpBuffer, &header, sizeof(header));
+   uint32 used = sizeof(header);
+   bool ok = true;
+
+   for(uint64 i = first; i < last && ok; ++i) {
+      if(used + sizeof(FlightEvent) + FLIGHT_SLOT_DATA > FLIGHT_DUMP_BUFFER) {
+         ok = writeAll(fd, dumpBuffer, used);
+         used = 0;
+      }
+
+      // Slots rewritten while they're copied are left out
+      const FlightSlot& slot = slots[i & (FLIGHT_SLOTS-1)];
+      if(slot.sequence.load(std::memory_order_acquire) != i+1) {
+         continue;
+      }
+
+      FlightEvent event = slot.event;
+      uint32 kept = event.length < FLIGHT_SLOT_DATA ? event.length : FLIGHT_SLOT_DATA;
+      memcpy(dumpBuffer + used, &event, sizeof(event));
+      memcpy(dumpBuffer + used + sizeof(event), slot.data, kept);
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      if(slot.sequence.load(std::memory_order_relaxed) == i+1 && event.time >= oldest) {
+         used += sizeof(event) + kept;
+      }
+   }
+
+   ok = ok && writeAll(fd, dumpBuffer, used);
+   ok = closeDump(fd) == 0 && ok;
+   dumping.store(false);
+   return ok;
+}
+
+static void printHex(const uint8* buffer, uint32 size) {
+   for(uint32 line = 0; line < size; line += 16) {
+      uint32 end = line+16 < size ? line+16 : size;
+      printf("%04u-%04u ", line, end-1);
+      for(uint32 i = line; i < line+16; ++i) {
+         if(i < end) {
+            printf("%02x ", buffer[i]);
+         } else {
+            printf("   ");
+         }
+      }
+      for(uint32 i = line; i < end; ++i) {
+         printf("%c", buffer[i] >= 32 && buffer[i] <= 126 ? buffer[i] : '.');
+      }
+      puts("");
+   }
+}
+
+bool FlightRecorder::print(const char* fileName) {
+   FILE* f = fopen(fileName, "rb");
+   if(!f) {
+      printf("Couldn't open %s\n", fileName);
+      return false;
+   }
+
+   FlightHeader header;
+   if(fread(&header, sizeof(header), 1, f) != 1 || header.magic != FLIGHT_MAGIC || header.version != FLIGHT_VERSION) {
+      printf("%s isn't a flight recorder dump of version %d\n", fileName, FLIGHT_VERSION);
+      fclose(f);
+      return false;
+   }
+
+   time_t started = header.startTime;
+   printf("Recorder started %s%llu events recorded in all\n\n", ctime(&started), (unsigned long long)header.events);
+
+   static const char* results[] = { "refused", "handled", "no handler", "pending" };
+   FlightEvent event;
+   std::vector<uint8> data(header.slotData);
+
+   while(fread(&event, sizeof(event), 1, f) == 1) {
+      uint32 kept = event.length < header.slotData ? event.length : header.slotData;
+      if(kept && fread(&data[0], kept, 1, f) != 1) {
+         break;
+      }
+
+      printf("%llu.%06llu tick %u ", (unsigned long long)(event.time/1000000), (unsigned long long)(event.time%1000000), event.tick);
+      switch(event.type) {
+      case FLIGHT_INBOUND:
+         printf("peer %u -> server, channel %u, %u bytes, %s\n", event.peer, event.channel, event.length, event.value <= FLIGHT_PENDING ? results[event.value] : "?");
+         break;
+      case FLIGHT_OUTBOUND:
+         printf("server -> peer %u, channel %u, %u bytes%s\n", event.peer, event.channel, event.length, event.value & 1 ? ", reliable" : "");
+         break;
+      case FLIGHT_TICK:
+         printf("took %.2f ms\n", event.value/1000.0);
+         break;
+      case FLIGHT_CONNECT:
+         printf("peer %u connected\n", event.peer);
+         break;
+      case FLIGHT_DISCONNECT:
+         printf("peer %u disconnected\n", event.peer);
+         break;
+      default:
+         printf("unknown event %u\n", event.type);
+         break;
+      }
+
+      if(kept) {
+         printHex(&data[0], kept);
+         if(kept < event.length) {
+            printf("(%u more bytes not kept)\n", event.length - kept);
+         }
+         puts("");
+      }
+   }
+
+   fclose(f);
+   return true;
+}
@@ -22,60 +22,140 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <sys/time.h>
 #include <algorithm>
+#include <ctime>
 #include "stdafx.h"
 #include "Game.h"
+#include "FlightRecorder.h"
+#include "PacketPool.h"
+#include "Profiler.h"
 
 #define REFRESH_RATE 5
 
-uint32 GetNewNetID() {
-	static uint32 dwStart = 0x40000019;
-	uint32 dwRet = dwStart;
-	dwStart++;
-	return dwRet;
-}
-
-Game::Game() : _started(false)
+Game::Game() : _started(false), _server(0), _blowfish(0), _tick(0), map(0)
 {
-
+   encryptOutgoing.game = this;
 }
 
 Game::~Game()
 {
 	_isAlive = false;
+	JobSystem::getInstance().wait(encryptGroup);
+	SendQueue::discard(outgoing.data(), outgoing.size());
 
 	delete _blowfish;
-	enet_host_destroy(_server);
+	if(_server)
+		enet_host_destroy(_server);
 }
 
-bool Game::initialize(ENetAddress *address, const char *baseKey)
+/**
+ * Everything but the network, shared with the replays
+ */
+bool Game::initializeGame(const char *baseKey, uint32 seed)
 {
-	if (enet_initialize () != 0)
-		return false;
-	atexit(enet_deinitialize);
-
-	_server = enet_host_create(address, 32, 0, 0);
-	if(_server == NULL)
-		return false;
-
 	std::string key = base64_decode(baseKey);
 	if(key.length() <= 0)
 		return false;
       
 	_blowfish = new BlowFish((uint8*)key.c_str(), 16);
 	initHandlers();
+	
+	if(!GameData::getInstance().load(GAMEDATA_FILE))
+		return false;
    
+   srand(seed);
    map = new Map(this);
 	
 	return _isAlive = true;
 }
 
+bool Game::initialize(ENetAddress *address, const char *baseKey, const char *snapshotFile, uint32 peerCapacity)
+{
+	if (PacketPool::initializeENet() != 0)
+		return false;
+	atexit(enet_deinitialize);
+
+	_server = enet_host_create(address, peerCapacity, 0, 0);
+	if(_server == NULL)
+		return false;
+
+   uint32 seed = time(0);
+	if(!initializeGame(baseKey, seed))
+		return false;
+   
+   if(snapshotFile && !restoreSnapshot(snapshotFile))
+      return false;
+   
+   char journalFile[64];
+   time_t started = seed;
+   strftime(journalFile, sizeof(journalFile), "journal-%Y%m%d-%H%M%S.iwj", localtime(&started));
+   _journal.open(journalFile, seed);
+   
+   return true;
+}
+
+void Game::onConnect(ENetPeer *peer)
+{
+   _journal.writeConnect(peer->incomingPeerID);
+   FlightRecorder::getInstance().record(FLIGHT_CONNECT, _tick, peer->incomingPeerID, 0, 0);
+   
+   peer->data = new ClientInfo();
+   peerInfo(peer)->setName("Test");
+   peerInfo(peer)->setSkinNo(6);
+   resync(peer);
+   
+   // Players of a restored game take their champions back in connection order
+   if(!_restoredChampions.empty()) {
+      peerInfo(peer)->setChampion(_restoredChampions.front());
+      _restoredChampions.erase(_restoredChampions.begin());
+      return;
+   }
+   
+   peerInfo(peer)->setChampion(ChampionFactory::getChampionFromType("Ezreal", map, map->getNewNetId()));
+   map->addObject(peerInfo(peer)->getChampion());
+}
+
+void Game::onDisconnect(ENetPeer *peer)
+{
+   _journal.writeDisconnect(peer->incomingPeerID);
+   FlightRecorder::getInstance().record(FLIGHT_DISCONNECT, _tick, peer->incomingPeerID, 0, 0);
+   
+   // Its packets still being encrypted use its key, and won't be sent
+   JobSystem::getInstance().wait(encryptGroup);
+   for(auto& p : outgoingPeers) {
+      if(p.first == peer) {
+         p.first = 0;
+      }
+   }
+   delete (ClientInfo*)peer->data;
+   peer->data = 0;
+}
+
+void Game::updateMap(uint16 diff)
+{
+   // Skillshots are checked against what each player saw, replays read the delays back from the journal
+   forEachClient([this](ENetPeer *peer) {
+      Champion* c = peerInfo(peer)->getChampion();
+      if(c && c->getViewDelay() != peer->roundTripTime) {
+         _journal.writeViewDelay(peer->incomingPeerID, peer->roundTripTime);
+         c->setViewDelay(peer->roundTripTime);
+      }
+   });
+   _journal.writeTick(diff);
+   map->update(diff);
+   ++_tick;
+}
+
 void Game::netLoop()
 {
 	ENetEvent event;
    struct timeval tStart, tEnd, tDiff;
+   gettimeofday(&tStart, 0);
 
 	while(true)
 	{
+      // A tick spans the whole pass, from reading the packets to sending the replies
+      uint64 tickStart = Profiler::now();
+      uint32 tick = _tick;
       while(enet_host_service(_server, & event, 1) > 0) {
          switch (event.type)
          {
@@ -84,13 +164,7 @@ void Game::netLoop()
 
             /* Set some defaults */
             event.peer->mtu = PEER_MTU;
-
-            event.peer->data = new ClientInfo();
-            peerInfo(event.peer)->setName("Test");
-            peerInfo(event.peer)->setChampion(ChampionFactory::getChampionFromType("Ezreal", map, GetNewNetID()));
-            peerInfo(event.peer)->setSkinNo(6);
-            map->addObject(peerInfo(event.peer)->getChampion());
-
+            onConnect(event.peer);
             break;
 
          case ENET_EVENT_TYPE_RECEIVE:
@@ -105,16 +179,92 @@ void Game::netLoop()
             break;
 
          case ENET_EVENT_TYPE_DISCONNECT:
-            delete (ClientInfo*)event.peer->data;
+            onDisconnect(event.peer);
             break;
          }
       }
+      Profiler::getInstance().record("net.service", tickStart, Profiler::now());
       tEnd = tStart;
       gettimeofday(&tStart, 0);
       timersub(&tStart, &tEnd, &tDiff);
-      if(_started) {
-         map->update(tDiff.tv_sec*1000 + tDiff.tv_usec/1000);
+      bool ticked = _started;
+      if(ticked) {
+         updateMap(std::min(tDiff.tv_sec*1000 + tDiff.tv_usec/1000, 0xFFFFL));
       }
+      flushSendQueues(tDiff.tv_sec*1000 + tDiff.tv_usec/1000);
+      if(ticked) {
+         FlightRecorder::getInstance().recordTick(tick, Profiler::getInstance().endTick(tick, tickStart));
+      }
+      FlightRecorder::getInstance().poll(_tick);
       usleep(REFRESH_RATE*1000);
    }
 }
+
+bool Game::replay(const char *journalFile, const char *baseKey)
+{
+   JournalReader reader;
+   if(PacketPool::initializeENet() != 0 || !reader.open(journalFile) || !initializeGame(baseKey, reader.getSeed()))
+      return false;
+   
+   std::map<uint16, ENetPeer*> peers;
+   JournalRecord record;
+   uint32 packets = 0;
+   uint64 gameTime = 0;
+   struct timeval tStart, tEnd, tDiff;
+   gettimeofday(&tStart, 0);
+   
+   while(reader.next(record)) {
+      switch(record.type) {
+      case JOURNAL_CONNECT: {
+         ENetPeer* peer = new ENetPeer();
+         peer->incomingPeerID = record.peer;
+         peers[record.peer] = peer;
+         onConnect(peer);
+         break;
+      }
+      case JOURNAL_DISCONNECT:
+         if(peers.count(record.peer)) {
+            onDisconnect(peers[record.peer]);
+            delete peers[record.peer];
+            peers.erase(record.peer);
+         }
+         break;
+      case JOURNAL_PACKET:
+         if(peers.count(record.peer) && !record.data.empty()) {
+            ENetPacket* packet = enet_packet_create(&record.data[0], record.data.size(), 0);
+            currentPeer = peers[record.peer];
+            dispatchPacket(currentPeer, packet, record.channel);
+            enet_packet_destroy(packet);
+            ++packets;
+         }
+         break;
+      case JOURNAL_VIEW_DELAY:
+         if(peers.count(record.peer) && peerInfo(peers[record.peer])->getChampion()) {
+            peerInfo(peers[record.peer])->getChampion()->setViewDelay(record.viewDelay);
+         }
+         break;
+      case JOURNAL_TICK: {
+         uint64 tickStart = Profiler::now();
+         uint32 tick = _tick;
+         updateMap(record.diff);
+         FlightRecorder::getInstance().recordTick(tick, Profiler::getInstance().endTick(tick, tickStart));
+         gameTime += record.diff;
+         break;
+      }
+      }
+   }
+   
+   gettimeofday(&tEnd, 0);
+   timersub(&tEnd, &tStart, &tDiff);
+   double elapsed = tDiff.tv_sec + tDiff.tv_usec/1000000.0;
+   
+   printf("Replayed %u ticks and %u packets, %.1f s of game in %.3f s (x%.1f)\n", _tick, packets, gameTime/1000.0, elapsed, elapsed > 0 ? gameTime/1000.0/elapsed : 0);
+   PacketPool::getInstance().printStats();
+   
+   for(auto& kv : peers) {
+      delete (ClientInfo*)kv.second->data;
+      delete kv.second;
+   }
+   
+   return true;
+}
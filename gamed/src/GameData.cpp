@@ -0,0 +1,154 @@
+#include "GameData.h"
+
+#if defined(WIN32) || defined(_WIN32)
+   #include <windows.h>
+#else
+   #include <fcntl.h>
+   #include <sys/mman.h>
+   #include <sys/stat.h>
+   #include <unistd.h>
+#endif
+
+using namespace std;
+
+GameData::GameData() : data(0), size(0), header(0) {
+#if defined(WIN32) || defined(_WIN32)
+   file = INVALID_HANDLE_VALUE;
+   mapping = 0;
+#endif
+}
+
+GameData::~GameData() {
+   unload();
+}
+
+GameData& GameData::getInstance() {
+   static GameData instance;
+   return instance;
+}
+
+void GameData::unload() {
+   if(!data) {
+      return;
+   }
+
+#if defined(WIN32) || defined(_WIN32)
+   UnmapViewOfFile(data);
+   CloseHandle(mapping);
+   CloseHandle(file);
+   file = INVALID_HANDLE_VALUE;
+   mapping = 0;
+#else
+   munmap((void*)data, size);
+#endif
+
+   data = 0;
+   header = 0;
+   size = 0;
+}
+
+bool GameData::load(const string& fileName) {
+   unload();
+
+#if defined(WIN32) || defined(_WIN32)
+   file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+   if(file == INVALID_HANDLE_VALUE) {
+      printf("Couldn't open %s\n", fileName.c_str());
+      return false;
+   }
+
+   size = GetFileSize(file, 0);
+   mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+   data = mapping ? (const uint8*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : 0;
+   if(!data) {
+      printf("Couldn't map %s\n", fileName.c_str());
+      if(mapping) {
+         CloseHandle(mapping);
+      }
+      CloseHandle(file);
+      file = INVALID_HANDLE_VALUE;
+      mapping = 0;
+      return false;
+   }
+#else
+   int fd = open(fileName.c_str(), O_RDONLY);
+   if(fd < 0) {
+      printf("Couldn't open %s\n", fileName.c_str());
+      return false;
+   }
+
+   struct stat st;
+   if(fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(GameDataHeader)) {
+      printf("%s is too small to hold game data\n", fileName.c_str());
+      close(fd);
+      return false;
+   }
+
+   size = st.st_size;
+   void* mapped = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+
+   if(mapped == MAP_FAILED) {
+      printf("Couldn't map %s\n", fileName.c_str());
+      size = 0;
+      return false;
+   }
+   data = (const uint8*)mapped;
+#endif
+
+   header = (const GameDataHeader*)data;
+
+   if(size < sizeof(GameDataHeader) || header->magic != GAMEDATA_MAGIC || header->size != size) {
+      printf("%s is not a valid game data file\n", fileName.c_str());
+      unload();
+      return false;
+   }
+
+   if(header->version != GAMEDATA_VERSION) {
+      printf("%s has version %u, expected %u. Recompile it with compiledata\n", fileName.c_str(), header->version, GAMEDATA_VERSION);
+      unload();
+      return false;
+   }
+
+   if((header->bucketCount & (header->bucketCount-1)) != 0 ||
+      header->bucketOffset + header->bucketCount*sizeof(GameDataBucket) > size ||
+      header->championOffset + header->championCount*sizeof(ChampionData) > size ||
+      header->spellOffset + header->spellCount*sizeof(SpellData) > size ||
+      header->itemOffset + header->itemCount*sizeof(ItemData) > size) {
+      printf("%s is truncated\n", fileName.c_str());
+      unload();
+      return false;
+   }
+
+   printf("Loaded %u champions, %u spells and %u items from %s\n", header->championCount, header->spellCount, header->itemCount, fileName.c_str());
+   return true;
+}
+
+const void* GameData::find(DataKind kind, uint32 key) const {
+   if(!header || !header->bucketCount) {
+      return 0;
+   }
+
+   const GameDataBucket* buckets = (const GameDataBucket*)(data + header->bucketOffset);
+   uint32 mask = header->bucketCount-1;
+
+   // The table is at most half full, so probing normally ends on an empty slot
+   for(uint32 n = 0, i = key & mask; n < header->bucketCount && buckets[i].kind != DATA_NONE; ++n, i = (i+1) & mask) {
+      if(buckets[i].key != key || buckets[i].kind != kind) {
+         continue;
+      }
+
+      switch(kind) {
+      case DATA_CHAMPION:
+         return data + header->championOffset + buckets[i].index*sizeof(ChampionData);
+      case DATA_SPELL:
+         return data + header->spellOffset + buckets[i].index*sizeof(SpellData);
+      case DATA_ITEM:
+         return data + header->itemOffset + buckets[i].index*sizeof(ItemData);
+      default:
+         return 0;
+      }
+   }
+
+   return 0;
+}
@@ -19,6 +19,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Game.h"
 #include "Packets.h"
 #include "ChatBox.h"
+#include "Turret.h"
+#include "Profiler.h"
 
 #include <vector>
 #include <string>
@@ -45,6 +47,9 @@ bool Game::handleKeyCheck(ENetPeer *peer, ENetPacket *packet) {
        // PDEBUG_LOG_LINE(//Logging, " User got the same key as i do, go on!\n");
         peerInfo(peer)->keyChecked = true;
         peerInfo(peer)->userId = userId;
+        // Every player uses the game's key for now, a player's own key would be picked here from partialKey
+        delete peerInfo(peer)->blowfish;
+        peerInfo(peer)->blowfish = new BlowFish(_blowfish->getKey(), _blowfish->getKeySize());
     } else {
         //Logging->errorLine(" WRONG KEY, GTFO!!!\n");
         return false;
@@ -106,44 +111,19 @@ bool Game::handleSpawn(ENetPeer *peer, ENetPacket *packet) {
 	
     notifySetHealth(peerInfo(peer)->getChampion());
     //Spawn Turrets
-    vector<string> szTurrets = {
-        "@Turret_T1_R_03_A",
-        "@Turret_T1_R_02_A",
-        "@Turret_T1_C_07_A",
-        "@Turret_T2_R_03_A",
-        "@Turret_T2_R_02_A",
-        "@Turret_T2_R_01_A",
-        "@Turret_T1_C_05_A",
-        "@Turret_T1_C_04_A",
-        "@Turret_T1_C_03_A",
-        "@Turret_T1_C_01_A",
-        "@Turret_T1_C_02_A",
-        "@Turret_T2_C_05_A",
-        "@Turret_T2_C_04_A",
-        "@Turret_T2_C_03_A",
-        "@Turret_T2_C_01_A",
-        "@Turret_T2_C_02_A",
-        "@Turret_OrderTurretShrine_A",
-        "@Turret_ChaosTurretShrine_A",
-        "@Turret_T1_L_03_A",
-        "@Turret_T1_L_02_A",
-        "@Turret_T1_C_06_A",
-        "@Turret_T2_L_03_A",
-        "@Turret_T2_L_02_A",
-        "@Turret_T2_L_01_A"
-    };
-    for(unsigned int i = 0; i < 24; i++) {
-        TurretSpawn turretSpawn(GetNewNetID(), szTurrets[i]);
+    for(uint32 i = 0; i < map->getTurretCount(); i++) {
+        Turret& t = map->getTurrets()[i];
+        TurretSpawn turretSpawn(t.getNetId(), t.getName());
         sendPacket(peer, turretSpawn, CHL_S2C);
     }
     //Spawn Props
-    LevelPropSpawn lpSpawn(GetNewNetID(), "LevelProp_Yonkey", "Yonkey", 12465, 14422.257f, 101);
+    LevelPropSpawn lpSpawn(map->getNewNetId(), "LevelProp_Yonkey", "Yonkey", 12465, 14422.257f, 101);
     sendPacket(peer, lpSpawn, CHL_S2C);
-    LevelPropSpawn lpSpawn2(GetNewNetID(), "LevelProp_Yonkey1", "Yonkey", -76, 1769.1589f, 94);
+    LevelPropSpawn lpSpawn2(map->getNewNetId(), "LevelProp_Yonkey1", "Yonkey", -76, 1769.1589f, 94);
     sendPacket(peer, lpSpawn2, CHL_S2C);
-    LevelPropSpawn lpSpawn3(GetNewNetID(), "LevelProp_ShopMale", "ShopMale", 13374, 14245.673f, 194);
+    LevelPropSpawn lpSpawn3(map->getNewNetId(), "LevelProp_ShopMale", "ShopMale", 13374, 14245.673f, 194);
     sendPacket(peer, lpSpawn3, CHL_S2C);
-    LevelPropSpawn lpSpawn4(GetNewNetID(), "LevelProp_ShopMale1", "ShopMale", -99, 855.6632f, 191);
+    LevelPropSpawn lpSpawn4(map->getNewNetId(), "LevelProp_ShopMale1", "ShopMale", -99, 855.6632f, 191);
     sendPacket(peer, lpSpawn4, CHL_S2C);
     
     StatePacket end(PKT_S2C_EndSpawn);
@@ -168,11 +148,12 @@ bool Game::handleStartGame(HANDLE_ARGS) {
    sendPacket(peer, start, CHL_S2C);
    
    _started = true;
+   map->start();
    
    /*
    FogUpdate2 test(peerInfo(peer)->getChampion()->getNetId(), 0, 0, 2);
    sendPacket(peer, test, CHL_S2C);
-   TODO : Create class Turret (like Champion or Minion) to change Fog (and Masks)
+   TODO : Use the turrets to change Fog (and Masks)
    */
    return true;
 }
@@ -255,6 +236,7 @@ bool Game::handleMove(ENetPeer *peer, ENetPacket *packet) {
       return true;
    }
    
+   peerInfo(peer)->getChampion()->getAutoAttack().stop();
    peerInfo(peer)->getChampion()->setWaypoints(vMoves);
 
    return true;
@@ -284,6 +266,13 @@ bool Game::handleQueryStatus(HANDLE_ARGS) {
 bool Game::handleClick(HANDLE_ARGS) {
    Click *click = reinterpret_cast<Click *>(packet->data);
    printf("Object %u clicked on %u\n", peerInfo(peer)->getChampion()->getNetId(),click->targetNetId);
+   
+   Champion* champion = peerInfo(peer)->getChampion();
+   Unit* target = dynamic_cast<Unit*>(map->getObjectById(click->targetNetId));
+   if(target && target->getSide() != champion->getSide()) {
+      champion->getAutoAttack().start(target);
+   }
+   
    Unk response(peerInfo(peer)->getChampion()->getNetId(), 0, 0, click->targetNetId);
    return sendPacket(peer, reinterpret_cast<uint8 *>(&response), sizeof(response), CHL_S2C);
 }
@@ -305,7 +294,7 @@ bool Game::handleCastSpell(HANDLE_ARGS) {
    CastSpellAns response(s, spell->x, spell->y);
    sendPacket(peer, response, CHL_S2C);
 
-   SpawnProjectile sp(GetNewNetID(), peerInfo(peer)->getChampion(), spell->x, spell->y);
+   SpawnProjectile sp(map->getNewNetId(), peerInfo(peer)->getChampion(), spell->x, spell->y);
    sendPacket(peer, sp, CHL_S2C);
 
    return true;
@@ -315,7 +304,7 @@ bool Game::handleChatBoxMessage(HANDLE_ARGS) {
     ChatMessage *message = reinterpret_cast<ChatMessage *>(packet->data);
     //Lets do commands
     if(message->msg == '.') {
-        const char *cmd[] = { ".set", ".gold", ".speed", ".health", ".xp", ".ap", ".ad", ".mana", ".model", ".help", ".spawn" };
+        const char *cmd[] = { ".set", ".gold", ".speed", ".health", ".xp", ".ap", ".ad", ".mana", ".model", ".help", ".spawn", ".snapshot", ".profile" };
         //Set field
         if(strncmp(message->getMessage(), cmd[0], strlen(cmd[0])) == 0) {
             uint32 blockNo, fieldNo;
@@ -360,13 +349,33 @@ bool Game::handleChatBoxMessage(HANDLE_ARGS) {
                                                             };
                           
             for(int i = 0; i < 6; ++i) {                                     
-               Minion* m = new Minion(map, GetNewNetID(), MINION_TYPE_MELEE, positions[i]);
+               Minion* m = new Minion(map, map->getNewNetId(), MINION_TYPE_MELEE, positions[i]);
                map->addObject(m);
                notifyMinionSpawned(m);
+               m->getAI()->onSpawn();
             }
             return true;
          }
          
+         //snapshot
+         if(strncmp(message->getMessage(), cmd[11], strlen(cmd[11])) == 0)
+         {
+            char fileName[32];
+            sprintf(fileName, "snapshot-%u.iws", _tick);
+            saveSnapshot(fileName);
+            return true;
+         }
+         
+         //profile
+         if(strncmp(message->getMessage(), cmd[12], strlen(cmd[12])) == 0)
+         {
+            char fileName[32];
+            sprintf(fileName, "profile-%u.json", _tick);
+            if(Profiler::getInstance().writeTrace(fileName))
+               printf("Profile written to %s\n", fileName);
+            return true;
+         }
+         
         //health
         if(strncmp(message->getMessage(), cmd[3], strlen(cmd[3])) == 0)
         {
@@ -475,6 +484,16 @@ bool Game::handleBuyItem(HANDLE_ARGS) {
 	// TODO : Add to player a system to check slot open or not (and stacks)
     static int slot = 0;
     BuyItemReq *request = reinterpret_cast<BuyItemReq *>(packet->data);
+    
+    const ItemData* item = GameData::getInstance().getItem(request->id);
+    if(item) {
+        Champion* champion = peerInfo(peer)->getChampion();
+        for(uint32 i = 0; i < item->modifierCount; ++i) {
+            const ItemModifierData& m = item->modifiers[i];
+            champion->getModifiers().addModifier(item->id, (StatAttribute)m.attribute, (ModifierType)m.type, m.value);
+        }
+    }
+    
     BuyItemAns response(peerInfo(peer)->getChampion()->getNetId(), request->id, slot++, 1);
     return broadcastPacket(response, CHL_S2C);
 }
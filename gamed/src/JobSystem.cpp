@@ -0,0 +1,123 @@
+#include "JobSystem.h"
+
+using namespace std;
+
+JobSystem::JobSystem(uint32 threadCount) : caller(this_thread::get_id()), generation(0), stopping(false) {
+   for(uint32 i = 0; i < threadCount; ++i) {
+      queues.push_back(new WorkerQueue());
+   }
+
+   for(uint32 i = 1; i < threadCount; ++i) {
+      threads.push_back(thread(&JobSystem::workerLoop, this, i));
+   }
+}
+
+JobSystem::~JobSystem() {
+   {
+      lock_guard<mutex> guard(wakeLock);
+      stopping = true;
+   }
+   wake.notify_all();
+
+   for(thread& t : threads) {
+      t.join();
+   }
+
+   for(WorkerQueue* q : queues) {
+      delete q;
+   }
+}
+
+JobSystem& JobSystem::getInstance() {
+   static JobSystem instance(max(1u, thread::hardware_concurrency()));
+   return instance;
+}
+
+bool JobSystem::popOrSteal(uint32 worker, Job& job) {
+   {
+      WorkerQueue* own = queues[worker];
+      lock_guard<mutex> guard(own->lock);
+      if(!own->jobs.empty()) {
+         job = own->jobs.back();
+         own->jobs.pop_back();
+         return true;
+      }
+   }
+
+   for(uint32 i = 1; i < queues.size(); ++i) {
+      WorkerQueue* victim = queues[(worker + i) % queues.size()];
+      lock_guard<mutex> guard(victim->lock);
+      if(!victim->jobs.empty()) {
+         job = victim->jobs.front();
+         victim->jobs.pop_front();
+         return true;
+      }
+   }
+
+   return false;
+}
+
+void JobSystem::execute(const Job& job, uint32 worker) {
+   job.function(job.context, job.begin, job.end, worker);
+   job.remaining->fetch_sub(1, memory_order_acq_rel);
+}
+
+void JobSystem::workerLoop(uint32 worker) {
+   uint32 seen = 0;
+
+   for(;;) {
+      {
+         unique_lock<mutex> guard(wakeLock);
+         wake.wait(guard, [&] { return stopping || generation != seen; });
+         if(stopping) {
+            return;
+         }
+         seen = generation;
+      }
+
+      Job job;
+      while(popOrSteal(worker, job)) {
+         execute(job, worker);
+      }
+   }
+}
+
+void JobSystem::submit(JobGroup& group, uint32 count, uint32 grain, JobFunction function, void* context) {
+   assert(this_thread::get_id() == caller);
+   assert(group.isDone());
+
+   if(!count) {
+      return;
+   }
+
+   grain = max(1u, grain);
+   uint32 chunks = (count + grain - 1) / grain;
+   group.remaining.store(chunks, memory_order_release);
+
+   for(uint32 i = 0; i < chunks; ++i) {
+      Job job = { function, context, i*grain, min(count, (i+1)*grain), &group.remaining };
+      WorkerQueue* q = queues[i % queues.size()];
+      lock_guard<mutex> guard(q->lock);
+      q->jobs.push_back(job);
+   }
+
+   {
+      lock_guard<mutex> guard(wakeLock);
+      ++generation;
+   }
+   wake.notify_all();
+}
+
+void JobSystem::wait(JobGroup& group) {
+   assert(this_thread::get_id() == caller);
+
+   // Chunks of other groups may run here too, they're all the caller's
+   Job job;
+   while(!group.isDone()) {
+      if(popOrSteal(0, job)) {
+         execute(job, 0);
+      } else {
+         this_thread::yield();
+      }
+   }
+}
@@ -0,0 +1,155 @@
+#include "Journal.h"
+
+using namespace std;
+
+bool JournalWriter::open(const string& fileName, uint32 seed) {
+   close();
+
+   file = fopen(fileName.c_str(), "ab");
+   if(!file) {
+      printf("Couldn't open journal %s\n", fileName.c_str());
+      return false;
+   }
+
+   buffer.reserve(JOURNAL_FLUSH_SIZE*2);
+
+   JournalHeader header = { JOURNAL_MAGIC, JOURNAL_VERSION, 0, seed };
+   put(header);
+   flush();
+   return true;
+}
+
+void JournalWriter::close() {
+   if(!file) {
+      return;
+   }
+
+   flush();
+   fclose(file);
+   file = 0;
+}
+
+void JournalWriter::flush() {
+   if(file && !buffer.empty()) {
+      fwrite(&buffer[0], 1, buffer.size(), file);
+      fflush(file);
+   }
+   buffer.clear();
+}
+
+void JournalWriter::commit() {
+   if(buffer.size() >= JOURNAL_FLUSH_SIZE) {
+      flush();
+   }
+}
+
+void JournalWriter::writeTick(uint16 diff) {
+   if(!file) {
+      return;
+   }
+
+   put((uint8)JOURNAL_TICK);
+   put(diff);
+   commit();
+}
+
+void JournalWriter::writeConnect(uint16 peer) {
+   if(!file) {
+      return;
+   }
+
+   put((uint8)JOURNAL_CONNECT);
+   put(peer);
+   commit();
+}
+
+void JournalWriter::writeDisconnect(uint16 peer) {
+   if(!file) {
+      return;
+   }
+
+   put((uint8)JOURNAL_DISCONNECT);
+   put(peer);
+   commit();
+}
+
+void JournalWriter::writePacket(uint32 tick, uint16 peer, uint8 channel, const uint8* data, uint16 length) {
+   if(!file) {
+      return;
+   }
+
+   put((uint8)JOURNAL_PACKET);
+   put(tick);
+   put(peer);
+   put(channel);
+   put(length);
+   buffer.insert(buffer.end(), data, data + length);
+   commit();
+}
+
+void JournalWriter::writeViewDelay(uint16 peer, uint32 delay) {
+   if(!file) {
+      return;
+   }
+
+   put((uint8)JOURNAL_VIEW_DELAY);
+   put(peer);
+   put(delay);
+   commit();
+}
+
+JournalReader::~JournalReader() {
+   if(file) {
+      fclose(file);
+   }
+}
+
+bool JournalReader::open(const string& fileName) {
+   file = fopen(fileName.c_str(), "rb");
+   if(!file) {
+      printf("Couldn't open journal %s\n", fileName.c_str());
+      return false;
+   }
+
+   if(!get(header) || header.magic != JOURNAL_MAGIC) {
+      printf("%s is not a journal\n", fileName.c_str());
+      return false;
+   }
+
+   if(header.version > JOURNAL_VERSION) {
+      printf("%s has version %u, expected %u at most\n", fileName.c_str(), header.version, JOURNAL_VERSION);
+      return false;
+   }
+
+   return true;
+}
+
+bool JournalReader::next(JournalRecord& record) {
+   uint8 type;
+   if(!file || !get(type)) {
+      return false;
+   }
+
+   record.type = (JournalRecordType)type;
+
+   switch(record.type) {
+   case JOURNAL_TICK:
+      return get(record.diff);
+   case JOURNAL_CONNECT:
+   case JOURNAL_DISCONNECT:
+      return get(record.peer);
+   case JOURNAL_VIEW_DELAY:
+      return get(record.peer) && get(record.viewDelay);
+   case JOURNAL_PACKET: {
+      uint16 length;
+      if(!get(record.tick) || !get(record.peer) || !get(record.channel) || !get(length)) {
+         return false;
+      }
+      record.data.resize(length);
+      return length == 0 || fread(&record.data[0], 1, length, file) == length;
+   }
+   default:
+      printf("Unknown journal record %u\n", type);
+      return false;
+   }
+}
@@ -1,39 +1,261 @@
 #include "Map.h"
 #include "Game.h"
+#include "Turret.h"
+#include "Snapshot.h"
+#include "ChampionFactory.h"
+#include "Profiler.h"
 
+#include <new>
+
+Map::Map(Game* game) : nextNetId(FIRST_NET_ID), turretCount(0), firstTurretId(0), game(game), missiles(this), damage(this), waves(this) {
+   attackEvents.reserve(MISSILE_POOL_SIZE);
+   
+   // Turrets are created once and never move, keep them next to each other
+   turrets = static_cast<Turret*>(::operator new(TURRET_COUNT*sizeof(Turret)));
+   for(; turretCount < TURRET_COUNT; ++turretCount) {
+      uint32 id = getNewNetId();
+      if(!turretCount) {
+         firstTurretId = id;
+      }
+      new (&turrets[turretCount]) Turret(this, id, Turret::turretInfos[turretCount]);
+   }
+}
+
+Map::~Map() {
+   for(uint32 i = 0; i < turretCount; ++i) {
+      turrets[i].~Turret();
+   }
+   ::operator delete(turrets);
+}
+
+void Map::start() {
+   waves.start();
+   
+   for(uint32 i = 0; i < turretCount; ++i) {
+      turrets[i].activate();
+   }
+}
+
+/**
+ * A tick runs in phases, each one only writing what it owns:
+ *  1. timers     (serial)    spells, attacks and AI thinking, may write anything
+ *  2. integrate  (parallel)  movement and stat recomputation, each object writes itself only
+ *  3. index      (serial)    rebuilds the spatial grid from the new positions
+ *  4. queries    (parallel)  targeting queries, read the grid, write their own result
+ *  5. decisions  (serial)    queries answered to the AI in submission order
+ *  6. apply      (serial)    missiles, collisions and damage
+ *  7. capture    (serial)    copies the replicated state in a frame, packets are built from it
+ * Parallel phases never depend on the thread count or scheduling, so a tick
+ * always has the same outcome.
+ */
 void Map::update(unsigned int diff) {
-   for(std::map<uint32, Object*>::iterator kv = objects.begin(); kv != objects.end();) {
-      kv->second->update(diff);
-      
-      if(kv->second->isMovementUpdated()) {
-         game->notifyMovement(kv->second);
-         kv->second->clearMovementUpdated();
+   JobSystem& jobs = JobSystem::getInstance();
+   
+   {
+      PROFILE_SCOPE("map.timers");
+      timers.update(diff);
+   }
+   
+   updateList.clear();
+   for(auto& kv : objects) {
+      updateList.push_back(kv.second);
+   }
+   
+   auto integrateRange = [this, diff](uint32 begin, uint32 end, uint32) {
+      PROFILE_SCOPE("map.integrate.chunk");
+      for(uint32 i = begin; i < end; ++i) {
+         updateList[i]->integrate(diff);
       }
-      
-      Unit* u = dynamic_cast<Unit*>(kv->second);
-      
-      if(u && !u->getStats().getUpdatedStats().empty()) {
-         game->notifyUpdatedStats(u);
-         u->getStats().clearUpdatedStats();
+   };
+   {
+      PROFILE_SCOPE("map.integrate");
+      jobs.parallelFor(updateList.size(), 64, integrateRange);
+   }
+   
+   {
+      PROFILE_SCOPE("map.index");
+      targeting.getIndex().rebuild(objects, turrets, turretCount);
+   }
+   {
+      PROFILE_SCOPE("map.targeting");
+      targeting.process(jobs);
+   }
+   {
+      PROFILE_SCOPE("map.missiles");
+      missiles.update(diff);
+   }
+   
+   {
+      PROFILE_SCOPE("map.update");
+      for(std::map<uint32, Object*>::iterator kv = objects.begin(); kv != objects.end();) {
+         kv->second->update(diff);
+         
+         if(kv->second->isToRemove()) {
+            removedList.push_back(kv->second);
+            kv = objects.erase(kv);
+         } else {
+            ++kv;
+         }
       }
-      
-      if(kv->second->isToRemove()) {
-         delete kv->second;
-         kv = objects.erase(kv);
-      } else {
-         ++kv;
+   }
+   
+   if(!damage.isEmpty()) {
+      PROFILE_SCOPE("map.damage");
+      damage.process(damagedUnits);
+      game->notifyHealthUpdates(damagedUnits);
+      damagedUnits.clear();
+   }
+   
+   if(!attackEvents.empty()) {
+      PROFILE_SCOPE("map.attacks");
+      game->notifyAttackEvents(attackEvents);
+      attackEvents.clear();
+   }
+   
+   WorldFrame* frame;
+   {
+      PROFILE_SCOPE("map.capture");
+      frame = &world.beginFrame(timers.getTime());
+      for(auto& kv : objects) {
+         frame->capture(kv.second, false);
+      }
+      for(uint32 i = 0; i < turretCount; ++i) {
+         frame->capture(&turrets[i], false);
+      }
+      for(Object* o : removedList) {
+         frame->capture(o, true);
+         delete o;
+      }
+      removedList.clear();
+      history.record(*frame);
+      world.publish();
+   }
+   
+   game->notifyWorldFrame(*frame);
+}
+
+void Map::addAttackEvent(Unit* source, Unit* target) {
+   AttackEvent e = { source->getNetId(), target->getNetId(), target->getX(), target->getY() };
+   attackEvents.push_back(e);
+}
+
+void Map::markAllStatsUpdated() {
+   for(auto& kv : objects) {
+      Unit* u = dynamic_cast<Unit*>(kv.second);
+      if(u) {
+         u->getStats().markAllUpdated();
       }
    }
+   
+   for(uint32 i = 0; i < turretCount; ++i) {
+      turrets[i].getStats().markAllUpdated();
+   }
 }
 
 Object* Map::getObjectById(uint32 id) {
-   if(objects.find(id) == objects.end()) {
-      return 0;
+   if(id - firstTurretId < turretCount) {
+      return &turrets[id - firstTurretId];
    }
    
-   return objects[id];
+   std::map<uint32, Object*>::iterator it = objects.find(id);
+   return it == objects.end() ? 0 : it->second;
 }
 
 void Map::addObject(Object* o) {
    objects[o->getNetId()] = o;
-}
\ No newline at end of file
+   
+   Champion* c = dynamic_cast<Champion*>(o);
+   if(c) {
+      champions.push_back(c);
+   }
+}
+
+enum SnapshotObjectTag : uint8 {
+   SNAPSHOT_CHAMPION = 1,
+   SNAPSHOT_MINION = 2
+};
+
+void Map::save(SnapshotWriter& s) const {
+   s.put(timers.getTime());
+   waves.save(s);
+   missiles.save(s);
+   
+   s.put(turretCount);
+   s.put(firstTurretId);
+   for(uint32 i = 0; i < turretCount; ++i) {
+      turrets[i].save(s);
+   }
+   
+   std::vector<Unit*> units;
+   for(auto& kv : objects) {
+      if(!kv.second->isToRemove() && (dynamic_cast<Champion*>(kv.second) || dynamic_cast<Minion*>(kv.second))) {
+         units.push_back(static_cast<Unit*>(kv.second));
+      }
+   }
+   
+   s.put((uint32)units.size());
+   for(Unit* u : units) {
+      Champion* c = dynamic_cast<Champion*>(u);
+      if(c) {
+         s.put((uint8)SNAPSHOT_CHAMPION);
+         s.put(c->getNetId());
+         s.putString(c->getType());
+      } else {
+         Minion* m = static_cast<Minion*>(u);
+         s.put((uint8)SNAPSHOT_MINION);
+         s.put(m->getNetId());
+         s.put((uint8)m->getType());
+         s.put(m->getPosition());
+      }
+      u->save(s);
+   }
+}
+
+bool Map::load(SnapshotReader& s, std::vector<Champion*>& restored) {
+   // Timers are restored relative to the clock, it has to be set first
+   if(!objects.empty() || !timers.setTime(s.get<uint64>())) {
+      printf("Snapshots can only be restored into a new game\n");
+      return false;
+   }
+   
+   waves.load(s);
+   missiles.load(s);
+   
+   if(s.get<uint32>() != turretCount || s.get<uint32>() != firstTurretId) {
+      printf("Snapshot structures don't match the map\n");
+      return false;
+   }
+   for(uint32 i = 0; i < turretCount; ++i) {
+      turrets[i].load(s);
+   }
+   
+   uint32 count = s.get<uint32>();
+   for(uint32 i = 0; i < count && s.isValid(); ++i) {
+      uint8 tag = s.get<uint8>();
+      uint32 id = s.get<uint32>();
+      Unit* u;
+      
+      switch(tag) {
+      case SNAPSHOT_CHAMPION: {
+         Champion* c = ChampionFactory::getChampionFromType(s.getString(), this, id);
+         restored.push_back(c);
+         u = c;
+         break;
+      }
+      case SNAPSHOT_MINION: {
+         MinionSpawnType type = (MinionSpawnType)s.get<uint8>();
+         MinionSpawnPosition position = (MinionSpawnPosition)s.get<uint32>();
+         u = new Minion(this, id, type, position);
+         break;
+      }
+      default:
+         printf("Unknown object %u in snapshot\n", tag);
+         return false;
+      }
+      
+      addObject(u);
+      u->load(s);
+   }
+   
+   return s.isValid();
+}
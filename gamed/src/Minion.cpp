@@ -35,16 +35,26 @@ Minion::Minion(Map* map, uint32 id, MinionSpawnType type, MinionSpawnPosition po
       stats->setCurrentHealth(475.0f);
       stats->setMaxHealth(475.0f);
       stats->setBaseAd(12.0f);
+      stats->setRange(110.f);
       break;
    case MINION_TYPE_CASTER:
       stats->setCurrentHealth(279.0f);
       stats->setMaxHealth(279.0f);
       stats->setBaseAd(23.0f);
+      stats->setRange(550.f);
       break;
    case MINION_TYPE_CANNON:
       stats->setCurrentHealth(600.0f);
       stats->setMaxHealth(600.0f);
       stats->setBaseAd(40.0f);
+      stats->setRange(300.f);
       break;
    }
+   
+   stats->setMovementSpeed(325.f);
+}
+
+void Minion::die(Unit* killer) {
+   Unit::die(killer);
+   setToRemove();
 }
\ No newline at end of file
@@ -0,0 +1,170 @@
+#include "AI/MinionAI.h"
+#include "Minion.h"
+#include "Map.h"
+#include "Snapshot.h"
+
+#include <cmath>
+
+/**
+ * Lane paths from the blue base to the red one, red minions walk them backwards
+ */
+#define LANE_POINTS 6
+
+static const float lanePaths[3][LANE_POINTS][2] = {
+   { { 907, 1715 },  { 1200, 4500 },  { 1400, 12200 }, { 2600, 13600 }, { 11500, 13900 }, { 14455, 13159 } }, // LANE_TOP
+   { { 1443, 1663 }, { 3600, 3600 },  { 5800, 5800 },  { 8400, 8400 },  { 10400, 10400 }, { 12433, 12623 } }, // LANE_MID
+   { { 1533, 1321 }, { 4500, 1200 },  { 12200, 1400 }, { 13600, 2600 }, { 13900, 11500 }, { 12967, 12695 } }  // LANE_BOT
+};
+
+static MovementVector toVector(float x, float y) {
+   return MovementVector((x - MAP_WIDTH)/2, (y - MAP_HEIGHT)/2);
+}
+
+MinionAI::~MinionAI() {
+   me->getMap()->getTargeting().cancel(this);
+}
+
+void MinionAI::onSpawn() {
+   switch(static_cast<Minion*>(me)->getPosition()) {
+   case SPAWN_BLUE_TOP:
+   case SPAWN_RED_TOP:
+      lane = LANE_TOP;
+      break;
+   case SPAWN_BLUE_BOT:
+   case SPAWN_RED_BOT:
+      lane = LANE_BOT;
+      break;
+   default:
+      lane = LANE_MID;
+      break;
+   }
+
+   walkLane();
+   me->getMap()->getTimers().schedule(this, AI_COARSE_RATE);
+}
+
+void MinionAI::onDamageTaken(Unit* source, float) {
+   if(state == MINION_WALKING && source && source->getSide() != me->getSide()) {
+      targetId = source->getNetId();
+      think();
+   }
+}
+
+void MinionAI::moveTo(float x, float y) {
+   std::vector<MovementVector> path;
+   path.push_back(toVector(me->getX(), me->getY()));
+   path.push_back(toVector(x, y));
+   me->setWaypoints(path);
+}
+
+/**
+ * Resumes walking the lane from the point the minion is closest to
+ */
+void MinionAI::walkLane() {
+   state = MINION_WALKING;
+   targetId = 0;
+   me->getAutoAttack().stop();
+
+   bool red = (me->getSide() == 1);
+   int closest = 0;
+   float closestDistance = -1;
+
+   for(int i = 0; i < LANE_POINTS; ++i) {
+      const float* p = lanePaths[lane][red ? LANE_POINTS-1-i : i];
+      float d = me->distanceWith(p[0], p[1]);
+      if(closestDistance < 0 || d < closestDistance) {
+         closest = i;
+         closestDistance = d;
+      }
+   }
+
+   // Skip the closest point if we're already past it
+   if(closest < LANE_POINTS-1) {
+      const float* p = lanePaths[lane][red ? LANE_POINTS-1-closest : closest];
+      const float* next = lanePaths[lane][red ? LANE_POINTS-2-closest : closest+1];
+      if(me->distanceWith(next[0], next[1]) < std::sqrt((p[0]-next[0])*(p[0]-next[0]) + (p[1]-next[1])*(p[1]-next[1]))) {
+         ++closest;
+      }
+   }
+
+   std::vector<MovementVector> path;
+   path.push_back(toVector(me->getX(), me->getY()));
+   for(int i = closest; i < LANE_POINTS; ++i) {
+      const float* p = lanePaths[lane][red ? LANE_POINTS-1-i : i];
+      path.push_back(toVector(p[0], p[1]));
+   }
+
+   me->setWaypoints(path);
+}
+
+bool MinionAI::isNearChampion() {
+   for(Champion* c : me->getMap()->getChampions()) {
+      if(me->distanceWith(c) < AI_LOD_RANGE) {
+         return true;
+      }
+   }
+
+   return false;
+}
+
+void MinionAI::engage(Unit* target) {
+   targetId = target->getNetId();
+
+   if(me->distanceWith(target) <= me->getStats().getRange()) {
+      if(state != MINION_IN_RANGE) {
+         std::vector<MovementVector> stop(1, toVector(me->getX(), me->getY()));
+         me->setWaypoints(stop);
+         state = MINION_IN_RANGE;
+      }
+      me->getAutoAttack().start(target);
+   } else {
+      MovementVector point = toVector(target->getX(), target->getY());
+      if(state != MINION_CHASING || std::abs(point.x - chasePoint.x) + std::abs(point.y - chasePoint.y) > 50) {
+         chasePoint = point;
+         moveTo(target->getX(), target->getY());
+         state = MINION_CHASING;
+      }
+   }
+}
+
+void MinionAI::onTargetsFound(Unit** targets, uint32 count) {
+   if(count) {
+      engage(targets[0]);
+   } else if(state != MINION_WALKING) {
+      walkLane();
+   }
+}
+
+void MinionAI::think() {
+   Map* map = me->getMap();
+   Unit* target = targetId ? dynamic_cast<Unit*>(map->getObjectById(targetId)) : 0;
+
+   if(target && (target->getStats().getCurrentHealth() <= 0 || me->distanceWith(target) > AI_LEASH_RANGE)) {
+      target = 0;
+   }
+
+   if(target) {
+      engage(target);
+   } else {
+      TargetQuery query(me->getX(), me->getY(), AI_ACQUISITION_RANGE, me->getSide(), UNIT_ANY, 1, PriorityLaneRules);
+      map->getTargeting().submit(query, this);
+   }
+
+   map->getTimers().schedule(this, isNearChampion() ? AI_FULL_RATE : AI_COARSE_RATE);
+}
+
+void MinionAI::save(SnapshotWriter& s) const {
+   s.put(targetId);
+   s.put(chasePoint);
+   s.put(lane);
+   s.put(state);
+   s.putTimer(*this);
+}
+
+void MinionAI::load(SnapshotReader& s) {
+   targetId = s.get<uint32>();
+   chasePoint = s.get<MovementVector>();
+   lane = s.get<MinionLane>();
+   state = s.get<MinionAIState>();
+   s.getTimer(*this, me->getMap()->getTimers());
+}
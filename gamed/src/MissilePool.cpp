@@ -0,0 +1,72 @@
+#include "MissilePool.h"
+#include "Map.h"
+#include "Snapshot.h"
+
+#include <cmath>
+
+bool MissilePool::launch(Unit* owner, Unit* target, float damage, float speed) {
+   if(activeCount == missiles.size()) {
+      return false;
+   }
+
+   Missile& m = missiles[activeCount++];
+   m.ownerId = owner->getNetId();
+   m.targetId = target->getNetId();
+   m.x = owner->getX();
+   m.y = owner->getY();
+   m.speed = speed;
+   m.damage = damage;
+
+   return true;
+}
+
+void MissilePool::update(unsigned int diff) {
+   for(uint32 i = 0; i < activeCount;) {
+      Missile& m = missiles[i];
+      Unit* target = dynamic_cast<Unit*>(map->getObjectById(m.targetId));
+
+      bool done = !target || target->isToRemove() || target->getStats().getCurrentHealth() <= 0;
+
+      if(!done) {
+         float dx = target->getX() - m.x, dy = target->getY() - m.y;
+         float distance = std::sqrt(dx*dx + dy*dy);
+         float step = m.speed*diff/1000.f;
+
+         if(distance <= step) {
+            // The damage lands even if the owner died in the meantime
+            Unit* owner = dynamic_cast<Unit*>(map->getObjectById(m.ownerId));
+            map->getDamage().push(owner, target, m.damage, DAMAGE_TYPE_PHYSICAL, DAMAGE_SOURCE_ATTACK);
+            done = true;
+         } else {
+            m.x += dx/distance*step;
+            m.y += dy/distance*step;
+         }
+      }
+
+      // Keep the active missiles packed, the last one takes this slot
+      if(done) {
+         m = missiles[--activeCount];
+      } else {
+         ++i;
+      }
+   }
+}
+
+void MissilePool::save(SnapshotWriter& s) const {
+   s.put(activeCount);
+   if(activeCount) {
+      s.put(&missiles[0], activeCount*sizeof(Missile));
+   }
+}
+
+void MissilePool::load(SnapshotReader& s) {
+   activeCount = s.get<uint32>();
+   if(activeCount > missiles.size()) {
+      activeCount = 0;
+      s.fail();
+      return;
+   }
+   if(activeCount) {
+      s.get(&missiles[0], activeCount*sizeof(Missile));
+   }
+}
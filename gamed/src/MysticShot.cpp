@@ -12,7 +12,7 @@ void MysticShot::finishCasting() {
 
    Map* m = owner->getMap();
    
-   Projectile* p = new Projectile(owner->getMap(), GetNewNetID(), owner->getX(), owner->getY(), 1000, 1000, new Target(x, y), this, 2000.f);
+   Projectile* p = new Projectile(m, m->getNewNetId(), owner->getX(), owner->getY(), 1000, 1000, new Target(x, y), this, projectileSpeed);
    owner->getMap()->addObject(p);
 }
 
@@ -29,11 +29,11 @@ void MysticShot::applyEffects(Target* t, Projectile* p) {
       return;
    }
    
-   if(u->getSide() == owner->getSide()) {
+   if(u->getSide() == owner->getSide() || !level) {
       return;
    }
    
-   owner->dealDamageTo(u, damage[level], DAMAGE_TYPE_PHYSICAL, DAMAGE_SOURCE_SPELL);
+   owner->dealDamageTo(u, damage[level-1], DAMAGE_TYPE_PHYSICAL, DAMAGE_SOURCE_SPELL);
    
    p->setToRemove();
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "Game.h"
 #include "Packets.h"
+#include "Profiler.h"
 
 #include <iostream>
 
@@ -8,31 +9,48 @@ using namespace std;
 
 void Game::notifyMinionSpawned(Minion* m) {
    MinionSpawn ms(m);
-   sendPacket(currentPeer, ms, CHL_S2C);
+   broadcastPacket(ms, CHL_S2C);
    notifySetHealth(m);
 }
 
 void Game::notifySetHealth(Unit* u) {
    SetHealth sh(u);
-   sendPacket(currentPeer, sh, CHL_S2C);
+   broadcastPacket(sh, CHL_S2C);
+   
+   // Damage doesn't go through the stats updates, they must know the peers have this health
+   float health = u->getStats().getCurrentHealth();
+   forEachClient([&](ENetPeer *peer) {
+      peerInfo(peer)->replicated.recordStat(u->getNetId(), MM_Four, FM4_CurrentHp, health);
+   });
 }
 
-void Game::notifyUpdatedStats(Unit* u) {
-   UpdateStats us(u);
-   sendPacket(currentPeer, us, CHL_LOW_PRIORITY, 2);
+/**
+ * Sends every peer the stats of a unit it doesn't have yet
+ */
+void Game::notifyUpdatedStats(const WorldFrame& frame, const UnitView& u) {
+   uint32 masks[5];
+   forEachClient([&](ENetPeer *peer) {
+      uint8 masterMask = peerInfo(peer)->replicated.filterStats(u.netId, u.statMasterMask, &frame.statMasks[u.firstStatMask], &frame.statValues[u.firstStatValue], masks, statsBuffer);
+      if(masterMask) {
+         UpdateStats us(u.netId, masterMask, masks, &statsBuffer[0]);
+         sendPacket(peer, us, CHL_LOW_PRIORITY);
+      }
+   });
 }
 
-void Game::notifyMovement(Object* o) {
-   const std::vector<MovementVector>& waypoints = o->getWaypoints();
-   MovementAns *answer = MovementAns::create(waypoints.size()*2);
+void Game::notifyMovement(const WorldFrame& frame, const UnitView& u) {
+   const MovementVector* waypoints = &frame.waypoints[u.firstWaypoint];
+   MovementAns *answer = MovementAns::create(u.waypointCount*2);
    
-   for(int i = 0; i < waypoints.size(); i++) {
+#ifdef DEBUG_MOVEMENT
+   for(int i = 0; i < u.waypointCount; i++) {
       printf("     Vector %i, x: %f, y: %f\n", i, 2.0 * waypoints[i].x + MAP_WIDTH, 2.0 * waypoints[i].y + MAP_HEIGHT);
    }
+#endif
    
    answer->nbUpdates = 1;
-   answer->netId = o->getNetId();
-   for(int i = 0; i < waypoints.size(); i++) {
+   answer->netId = u.netId;
+   for(int i = 0; i < u.waypointCount; i++) {
       answer->getVector(i)->x = waypoints[i].x;
       answer->getVector(i)->y = waypoints[i].y;
    }
@@ -40,3 +58,45 @@ void Game::notifyMovement(Object* o) {
    broadcastPacket(reinterpret_cast<uint8 *>(answer), answer->size(), 4);
    MovementAns::destroy(answer);
 }
+
+void Game::notifyWorldFrame(const WorldFrame& frame) {
+   PROFILE_SCOPE("notify.frame");
+   for(const UnitView& u : frame.units) {
+      if(u.flags & VIEW_MOVED) {
+         notifyMovement(frame, u);
+      }
+      
+      if(u.flags & VIEW_STATS) {
+         notifyUpdatedStats(frame, u);
+      }
+      
+      if(u.flags & VIEW_REMOVED) {
+         forEachClient([&](ENetPeer *peer) {
+            peerInfo(peer)->replicated.forget(u.netId);
+         });
+      }
+   }
+}
+
+/**
+ * Sends every attack fired during the tick, one packet each. It only
+ * animates its source, so it goes unreliable.
+ * Attacks aren't batched, the client's batch encoding is unknown. Each
+ * packet is built on the stack and queued in a pooled ENet packet, so a
+ * warm server doesn't allocate for them.
+ */
+void Game::notifyAttackEvents(const std::vector<AttackEvent>& events) {
+   for(const AttackEvent& e : events) {
+      Unk attack(e.sourceId, e.x, e.y, e.targetId);
+      broadcastPacket(reinterpret_cast<uint8 *>(&attack), sizeof(attack), CHL_S2C, UNRELIABLE);
+   }
+}
+
+/**
+ * Sends the health of every unit damaged during the tick, once per unit
+ */
+void Game::notifyHealthUpdates(const std::vector<Unit*>& units) {
+   for(Unit* u : units) {
+      notifySetHealth(u);
+   }
+}
@@ -1,4 +1,5 @@
 #include "Object.h"
+#include "Snapshot.h"
 #include <cmath>
 
 using namespace std;
@@ -56,8 +57,17 @@ void Object::Move(unsigned int diff) {
 	}
 }
 
+void Object::integrate(unsigned int diff) {
+   if(target && target->isSimpleTarget()) {
+      Move(diff);
+   }
+}
+
+/* Following another object has to wait until it has moved */
 void Object::update(unsigned int diff) {
-   Move(diff);
+   if(target && !target->isSimpleTarget()) {
+      Move(diff);
+   }
 }
 
 void Object::setWaypoints(const std::vector<MovementVector>& newWaypoints) {
@@ -83,10 +93,14 @@ void Object::setPosition(float x, float y) {
 }
 
 bool Object::collide(Object* o) {
-   float minX = o->x - o->hitboxWidth/2;
-   float maxX = o->x + o->hitboxWidth/2;
-   float minY = o->y - o->hitboxHeight/2;
-   float maxY = o->y + o->hitboxHeight/2;
+   return collideAt(o, o->x, o->y);
+}
+
+bool Object::collideAt(Object* o, float x, float y) {
+   float minX = x - o->hitboxWidth/2;
+   float maxX = x + o->hitboxWidth/2;
+   float minY = y - o->hitboxHeight/2;
+   float maxY = y + o->hitboxHeight/2;
 
    if (  isPointInHitbox(minX, minY   ) ||
          isPointInHitbox(minX, maxY   ) ||
@@ -94,16 +108,21 @@ bool Object::collide(Object* o) {
          isPointInHitbox(maxX, maxY   )
       )
         return true;
-        
-   minX = this->x - hitboxWidth/2;
-   maxX = this->x + hitboxWidth/2;
-   minY = this->y - hitboxHeight/2;
-   maxY = this->y + hitboxHeight/2;
    
-   if (  o->isPointInHitbox(minX, minY   ) ||
-         o->isPointInHitbox(minX, maxY   ) ||
-         o->isPointInHitbox(maxX, minY   ) ||
-         o->isPointInHitbox(maxX, maxY   )
+   // Our corners in o's hitbox, o being at (x, y)
+   auto inOther = [&](float px, float py) {
+      return minX <= px && px <= maxX && minY <= py && py <= maxY;
+   };
+   
+   float myMinX = this->x - hitboxWidth/2;
+   float myMaxX = this->x + hitboxWidth/2;
+   float myMinY = this->y - hitboxHeight/2;
+   float myMaxY = this->y + hitboxHeight/2;
+   
+   if (  inOther(myMinX, myMinY   ) ||
+         inOther(myMinX, myMaxY   ) ||
+         inOther(myMaxX, myMinY   ) ||
+         inOther(myMaxX, myMaxY   )
       )
         return true;
     
@@ -120,4 +139,31 @@ bool Object::isPointInHitbox(float x, float y) {
         return true;
         
     return false;
-}
\ No newline at end of file
+}
+
+void Object::save(SnapshotWriter& s) const {
+   s.put(x);
+   s.put(y);
+   s.put(side);
+   s.put((uint32)waypoints.size());
+   if(!waypoints.empty()) {
+      s.put(&waypoints[0], waypoints.size()*sizeof(MovementVector));
+   }
+   s.put(curWaypoint);
+   s.put(target != 0);
+}
+
+void Object::load(SnapshotReader& s) {
+   x = s.get<float>();
+   y = s.get<float>();
+   side = s.get<unsigned int>();
+   waypoints.resize(s.get<uint32>());
+   if(!waypoints.empty()) {
+      s.get(&waypoints[0], waypoints.size()*sizeof(MovementVector));
+   }
+   curWaypoint = s.get<uint32>();
+
+   // Only waypoints are restored, following another object isn't
+   bool moving = s.get<bool>();
+   setTarget((moving && curWaypoint < waypoints.size()) ? waypoints[curWaypoint].toTarget() : 0);
+}
@@ -17,6 +17,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "Game.h"
 #include "Packets.h"
+#include "FlightRecorder.h"
+#include "JobSystem.h"
+#include "Profiler.h"
 #define min(a, b)       ((a) < (b) ? (a) : (b))
 
 void Game::initHandlers()
@@ -103,27 +106,20 @@ void Game::printLine(uint8 *buf, uint32 len)
 	//PDEBUG_LOG(Logging,"\n");
 }
 
-bool Game::sendPacket(ENetPeer *peer, const uint8 *source, uint32 length, uint8 channelNo, uint32 flag)
+bool Game::sendPacket(ENetPeer *peer, const uint8 *data, uint32 length, uint8 channelNo, uint32 flag)
 {
 	////PDEBUG_LOG_LINE(Logging," Sending packet:\n");
 	//if(length < 300)
 	//	printPacket(data, length);
    
-   uint8* data = new uint8[length];
-   memcpy(data, source, length);
-
-	if(length >= 8)
-		_blowfish->Encrypt(data, length-(length%8)); //Encrypt everything minus the last bytes that overflow the 8 byte boundary
-
-	ENetPacket *packet = enet_packet_create(data, length, flag);
-	if(enet_peer_send(peer, channelNo, packet) < 0)
-	{
-      delete[] data;
-		//PDEBUG_LOG_LINE(Logging,"Warning fail, send!");
-		return false;
-	}
+   if(!_server) {
+      return true; // Headless replay, nobody to send to
+   }
+   
+   if(!peer || !peer->data)
+      return false;
    
-   delete[] data;
+   peerInfo(peer)->sendQueue.push(data, length, channelNo, flag);
 	return true;
 }
 
@@ -131,39 +127,109 @@ bool Game::sendPacket(ENetPeer *peer, const Packet& packet, uint8 channelNo, uin
    return sendPacket(peer, (const uint8*)&packet.getBuffer().getBytes()[0], packet.getBuffer().size(), channelNo, flag);
 }
 
-bool Game::broadcastPacket(uint8 *data, uint32 length, uint8 channelNo, uint32 flag)
+bool Game::broadcastPacket(const uint8 *data, uint32 length, uint8 channelNo, uint32 flag)
 {
 	////PDEBUG_LOG_LINE(Logging," Broadcast packet:\n");
 	//printPacket(data, length);
 
-	if(length >= 8)
-		_blowfish->Encrypt(data, length-(length%8)); //Encrypt everything minus the last bytes that overflow the 8 byte boundary
+	forEachClient([&](ENetPeer *peer) {
+		peerInfo(peer)->sendQueue.push(data, length, channelNo, flag);
+	});
+	return true;
+}
 
-	ENetPacket *packet = enet_packet_create(data, length, flag);
+bool Game::broadcastPacket(const Packet& packet, uint8 channelNo, uint32 flag) {
+   return broadcastPacket(&packet.getBuffer().getBytes()[0], packet.getBuffer().size(), channelNo, flag);
+}
 
-	enet_host_broadcast(_server, channelNo, packet);
-	return true;
+/**
+ * Forgets what a peer was sent, every stat goes to it again with the next tick
+ */
+void Game::resync(ENetPeer *peer)
+{
+	peerInfo(peer)->replicated.clear();
+	if(map)
+		map->markAllStatsUpdated();
+}
+
+/**
+ * Hands the queued packets of every peer to ENet, within their budgets.
+ * The packets taken on a pass are encrypted together on the job system
+ * while the server loop goes on, and sent on the next pass peer by peer in
+ * their queue order, before the newer ones are taken.
+ */
+void Game::flushSendQueues(uint32 elapsed)
+{
+	PROFILE_SCOPE("net.flush");
+	{
+		PROFILE_SCOPE("net.encrypt.wait");
+		JobSystem::getInstance().wait(encryptGroup);
+	}
+	{
+		PROFILE_SCOPE("net.send");
+		uint32 first = 0;
+		for(auto& peer : outgoingPeers) {
+			if(!peer.first)
+				SendQueue::discard(outgoing.data() + first, peer.second - first);
+			else if(!SendQueue::send(peer.first, outgoing.data() + first, peer.second - first))
+				resync(peer.first);
+			first = peer.second;
+		}
+	}
+
+	outgoing.clear();
+	outgoingKeys.clear();
+	outgoingPeers.clear();
+	forEachClient([&](ENetPeer *peer) {
+		uint32 first = outgoing.size();
+		peerInfo(peer)->sendQueue.take(peer, elapsed, outgoing);
+		for(uint32 i = first; i < outgoing.size(); ++i)
+			FlightRecorder::getInstance().record(FLIGHT_OUTBOUND, _tick, peer->incomingPeerID, outgoing[i].channel, outgoing[i].packet->flags, outgoing[i].packet->data, outgoing[i].packet->dataLength);
+		outgoingKeys.resize(outgoing.size(), peerInfo(peer)->blowfish ? peerInfo(peer)->blowfish : _blowfish);
+		outgoingPeers.push_back(std::make_pair(peer, (uint32)outgoing.size()));
+	});
+
+	JobSystem::getInstance().parallelForAsync(encryptGroup, outgoing.size(), 32, encryptOutgoing);
+}
+
+void Game::EncryptOutgoing::operator()(uint32 begin, uint32 end, uint32)
+{
+	PROFILE_SCOPE("net.encrypt.chunk");
+	for(uint32 i = begin; i < end; ++i)
+		SendQueue::encrypt(game->outgoing[i], game->outgoingKeys[i]);
 }
 
 bool Game::handlePacket(ENetPeer *peer, ENetPacket *packet, uint8 channelID)
 {
+	PROFILE_SCOPE("net.handlePacket");
 	if(packet->dataLength >= 8)
 	{
 		if(peerInfo(peer)->keyChecked)
-			_blowfish->Decrypt(packet->data, packet->dataLength-(packet->dataLength%8)); //Encrypt everything minus the last bytes that overflow the 8 byte boundary
+			peerInfo(peer)->blowfish->Decrypt(packet->data, packet->dataLength-(packet->dataLength%8)); //Encrypt everything minus the last bytes that overflow the 8 byte boundary
 	}
 
+	return dispatchPacket(peer, packet, channelID);
+}
+
+bool Game::dispatchPacket(ENetPeer *peer, ENetPacket *packet, uint8 channelID)
+{
 	PacketHeader *header = reinterpret_cast<PacketHeader*>(packet->data);	
    printf("Handling OpCode %02X\n", header->cmd);
 	bool (Game::*handler)(HANDLE_ARGS) = _handlerTable[header->cmd][channelID];
 	
 	if(handler)
 	{
-		return (*this.*handler)(peer,packet);
+		_journal.writePacket(_tick, peer->incomingPeerID, channelID, packet->data, packet->dataLength);
+		// Recorded first, so a dump taken while the handler runs or crashes still has it
+		uint64 event = FlightRecorder::getInstance().record(FLIGHT_INBOUND, _tick, peer->incomingPeerID, channelID, FLIGHT_PENDING, packet->data, packet->dataLength);
+		bool handled = (*this.*handler)(peer,packet);
+		FlightRecorder::getInstance().setValue(event, handled ? FLIGHT_HANDLED : FLIGHT_REFUSED);
+		return handled;
 	}
 	else
 	{
 		//PDEBUG_LOG_LINE(Logging,"Unknown packet: CMD %X(%i) CHANNEL %X(%i)\n", header->cmd, header->cmd,channelID,channelID);
+		FlightRecorder::getInstance().record(FLIGHT_INBOUND, _tick, peer->incomingPeerID, channelID, FLIGHT_UNHANDLED, packet->data, packet->dataLength);
 		printPacket(packet->data, packet->dataLength);
 	}
 	return false;	
@@ -0,0 +1,124 @@
+#include "PacketPool.h"
+
+#include <enet/enet.h>
+
+#define POOL_LARGE 0xFF // Class of the blocks from malloc
+
+static void* ENET_CALLBACK poolMalloc(size_t size) {
+   return PacketPool::getInstance().allocate(size);
+}
+
+static void ENET_CALLBACK poolFree(void* memory) {
+   PacketPool::getInstance().release(memory);
+}
+
+PacketPool& PacketPool::getInstance() {
+   static PacketPool instance;
+   return instance;
+}
+
+int PacketPool::initializeENet() {
+   ENetCallbacks callbacks;
+   memset(&callbacks, 0, sizeof(callbacks));
+   callbacks.malloc = poolMalloc;
+   callbacks.free = poolFree;
+
+   return enet_initialize_with_callbacks(ENET_VERSION, &callbacks);
+}
+
+PacketPool::PacketPool() {
+   memset(freeLists, 0, sizeof(freeLists));
+   memset(&stats, 0, sizeof(stats));
+}
+
+PacketPool::~PacketPool() {
+   for(void* slab : slabs) {
+      free(slab);
+   }
+}
+
+/**
+ * Cuts a new slab in blocks of a class
+ */
+void PacketPool::refill(uint32 sizeClass) {
+   uint32 blockSize = POOL_MIN_BLOCK << sizeClass;
+   uint8* slab = (uint8*)malloc(POOL_SLAB_SIZE);
+   if(!slab) {
+      return;
+   }
+
+   slabs.push_back(slab);
+   ++stats.slabs;
+
+   for(uint32 offset = 0; offset + blockSize <= POOL_SLAB_SIZE; offset += blockSize) {
+      FreeBlock* block = (FreeBlock*)(slab + offset);
+      block->next = freeLists[sizeClass];
+      freeLists[sizeClass] = block;
+   }
+}
+
+void* PacketPool::allocate(size_t size) {
+   size_t total = size + POOL_HEADER_SIZE;
+   uint8* block;
+   uint32 sizeClass = 0;
+
+   while(sizeClass < POOL_CLASSES && (size_t)(POOL_MIN_BLOCK << sizeClass) < total) {
+      ++sizeClass;
+   }
+
+   if(sizeClass == POOL_CLASSES) {
+      block = (uint8*)malloc(total);
+      if(!block) {
+         return 0;
+      }
+      sizeClass = POOL_LARGE;
+      ++stats.fallbacks;
+   } else {
+      if(!freeLists[sizeClass]) {
+         refill(sizeClass);
+         if(!freeLists[sizeClass]) {
+            return 0;
+         }
+      }
+
+      block = (uint8*)freeLists[sizeClass];
+      freeLists[sizeClass] = freeLists[sizeClass]->next;
+
+      if(++stats.inUse[sizeClass] > stats.peak[sizeClass]) {
+         stats.peak[sizeClass] = stats.inUse[sizeClass];
+      }
+   }
+
+   ++stats.allocations;
+   block[0] = sizeClass;
+   return block + POOL_HEADER_SIZE;
+}
+
+void PacketPool::release(void* memory) {
+   if(!memory) {
+      return;
+   }
+
+   uint8* block = (uint8*)memory - POOL_HEADER_SIZE;
+   uint8 sizeClass = block[0];
+   ++stats.frees;
+
+   if(sizeClass == POOL_LARGE) {
+      free(block);
+      return;
+   }
+
+   FreeBlock* freed = (FreeBlock*)block;
+   freed->next = freeLists[sizeClass];
+   freeLists[sizeClass] = freed;
+   --stats.inUse[sizeClass];
+}
+
+void PacketPool::printStats() const {
+   printf("Packet pool: %llu allocations, %llu frees, %llu from malloc, %u slabs\n", (unsigned long long)stats.allocations, (unsigned long long)stats.frees, (unsigned long long)stats.fallbacks, stats.slabs);
+   for(uint32 i = 0; i < POOL_CLASSES; ++i) {
+      if(stats.peak[i]) {
+         printf("   %u bytes: %u in use, %u at most\n", POOL_MIN_BLOCK << i, stats.inUse[i], stats.peak[i]);
+      }
+   }
+}
@@ -0,0 +1,83 @@
+#include "PositionHistory.h"
+#include "WorldState.h"
+
+#include <algorithm>
+
+void PositionHistory::record(const WorldFrame& frame) {
+   uint32 index = frameCount % HISTORY_FRAMES;
+   times[index] = frame.time;
+
+   for(const UnitView& u : frame.units) {
+      if(!(u.flags & VIEW_UNIT)) {
+         continue;
+      }
+
+      auto it = slots.find(u.netId);
+
+      if(u.flags & VIEW_REMOVED) {
+         if(it != slots.end()) {
+            freeSlots.push_back(it->second);
+            slots.erase(it);
+         }
+         continue;
+      }
+
+      if(it == slots.end()) {
+         uint32 slot;
+         if(freeSlots.empty()) {
+            slot = slots.size();
+            xs.resize(xs.size() + HISTORY_FRAMES);
+            ys.resize(ys.size() + HISTORY_FRAMES);
+         } else {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+         }
+         it = slots.insert(std::make_pair(u.netId, slot)).first;
+
+         // A new unit was always where it is now
+         std::fill(xs.begin() + slot*HISTORY_FRAMES, xs.begin() + (slot+1)*HISTORY_FRAMES, u.x);
+         std::fill(ys.begin() + slot*HISTORY_FRAMES, ys.begin() + (slot+1)*HISTORY_FRAMES, u.y);
+      }
+
+      xs[it->second*HISTORY_FRAMES + index] = u.x;
+      ys[it->second*HISTORY_FRAMES + index] = u.y;
+   }
+
+   ++frameCount;
+}
+
+bool PositionHistory::getPosition(uint32 netId, uint64 time, float& x, float& y) const {
+   auto it = slots.find(netId);
+   if(it == slots.end() || !frameCount) {
+      return false;
+   }
+
+   const float* px = &xs[it->second*HISTORY_FRAMES];
+   const float* py = &ys[it->second*HISTORY_FRAMES];
+   uint32 frames = frameCount < HISTORY_FRAMES ? frameCount : HISTORY_FRAMES;
+   uint32 newer = (frameCount-1) % HISTORY_FRAMES;
+
+   if(time >= times[newer]) {
+      x = px[newer];
+      y = py[newer];
+      return true;
+   }
+
+   // Walk back to the first frame at or before the time
+   for(uint32 n = 1; n < frames; ++n) {
+      uint32 older = (frameCount-1-n) % HISTORY_FRAMES;
+
+      if(times[older] <= time) {
+         float t = (float)(time - times[older]) / (times[newer] - times[older]);
+         x = px[older] + (px[newer] - px[older])*t;
+         y = py[older] + (py[newer] - py[older])*t;
+         return true;
+      }
+
+      newer = older;
+   }
+
+   x = px[newer];
+   y = py[newer];
+   return true;
+}
@@ -0,0 +1,136 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+
+using namespace std;
+
+static uint64 steadyNs() {
+   return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler& Profiler::getInstance() {
+   static Profiler instance;
+   return instance;
+}
+
+/**
+ * Measures the counter's rate against the steady clock, over a few milliseconds
+ */
+Profiler::Profiler() : slowTicks(0) {
+   startCounter = now();
+   startNs = steadyNs();
+
+   uint64 ns;
+   do {
+      ns = steadyNs();
+   } while(ns - startNs < 5000000);
+
+   countsPerUs = (now() - startCounter) * 1000.0 / (ns - startNs);
+   if(countsPerUs <= 0) {
+      countsPerUs = 1000;
+   }
+}
+
+ProfileRing* Profiler::registerThread() {
+   ProfileRing* ring = new ProfileRing();
+   ring->count.store(0);
+
+   lock_guard<mutex> guard(lock);
+   ring->thread = rings.size();
+   rings.push_back(ring);
+   return ring;
+}
+
+bool Profiler::readSample(const ProfileRing* ring, uint64 index, ProfileSample& sample) {
+   sample = ring->samples[index & (PROFILE_RING_SIZE-1)];
+   atomic_thread_fence(memory_order_acquire);
+
+   // The slot is rewritten once its thread reaches the sample PROFILE_RING_SIZE later
+   return ring->count.load(memory_order_relaxed) - index < PROFILE_RING_SIZE;
+}
+
+double Profiler::endTick(uint32 tick, uint64 start) {
+   uint64 end = now();
+   record("tick", start, end);
+
+   double tickUs = (end - start) / countsPerUs;
+   if(tickUs < PROFILE_SLOW_TICK_US) {
+      return tickUs;
+   }
+
+   ++slowTicks;
+
+   // Time of each phase during the tick, on all threads
+   map<string, double> phases;
+   {
+      lock_guard<mutex> guard(lock);
+      for(ProfileRing* ring : rings) {
+         uint64 count = ring->count.load(memory_order_acquire);
+         uint64 first = count > PROFILE_RING_SIZE ? count - PROFILE_RING_SIZE : 0;
+
+         for(uint64 i = count; i > first; --i) {
+            ProfileSample sample;
+            if(!readSample(ring, i-1, sample)) {
+               break;
+            }
+            if(sample.end < start) {
+               break;
+            }
+            if(sample.start >= start && sample.end <= end) {
+               phases[sample.name] += (sample.end - sample.start) / countsPerUs;
+            }
+         }
+      }
+   }
+
+   vector<pair<double, string> > sorted;
+   for(auto& phase : phases) {
+      if(phase.first != "tick") {
+         sorted.push_back(make_pair(phase.second, phase.first));
+      }
+   }
+   sort(sorted.rbegin(), sorted.rend());
+
+   printf("Slow tick %u: %.1f ms", tick, tickUs/1000);
+   for(size_t i = 0; i < sorted.size() && i < PROFILE_SUMMARY_PHASES; ++i) {
+      printf("%s%s %.1f ms", i ? ", " : " (", sorted[i].second.c_str(), sorted[i].first/1000);
+   }
+   printf("%s\n", sorted.empty() ? "" : ")");
+   return tickUs;
+}
+
+bool Profiler::writeTrace(const char* fileName) {
+   FILE* f = fopen(fileName, "w");
+   if(!f) {
+      return false;
+   }
+
+   fprintf(f, "{\"traceEvents\":[\n");
+   bool first = true;
+
+   lock_guard<mutex> guard(lock);
+   for(ProfileRing* ring : rings) {
+      uint64 count = ring->count.load(memory_order_acquire);
+      uint64 i = count > PROFILE_RING_SIZE ? count - PROFILE_RING_SIZE : 0;
+
+      fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"thread %u\"}}",
+              first ? "" : ",\n", ring->thread, ring->thread);
+      first = false;
+
+      for(; i < count; ++i) {
+         ProfileSample sample;
+         if(!readSample(ring, i, sample)) {
+            continue;
+         }
+         fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                 sample.name, ring->thread, toUs(sample.start), (sample.end - sample.start) / countsPerUs);
+      }
+   }
+
+   fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+   fclose(f);
+   return true;
+}
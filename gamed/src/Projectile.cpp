@@ -2,6 +2,19 @@
 
 #include "Map.h"
 #include "Projectile.h"
+#include "Profiler.h"
+
+#include <algorithm>
+
+Projectile::Projectile(Map* map, uint32 id, float x, float y, int hitboxWidth, int hitboxHeight, Target* target, Spell* originSpell, float moveSpeed) : Object(map, id, x, y, hitboxWidth, hitboxHeight), originSpell(originSpell), moveSpeed(moveSpeed), rewind(0) {
+   setTarget(target);
+   
+   /* The cast left the client half a round trip ago, with the units as it
+      saw them half a round trip before that */
+   if(originSpell) {
+      rewind = std::min(originSpell->getOwner()->getViewDelay(), map->getHistory().getMaxRewind());
+   }
+}
 
 void Projectile::update(unsigned int diff) {
 
@@ -13,17 +26,35 @@ void Projectile::update(unsigned int diff) {
    }
    
    if(target->isSimpleTarget()) { // Skillshot
-      const std::map<uint32, Object*>& objects = map->getObjects();
-      for(auto& it : objects) {
+      std::vector<Object*> hits;
+      sweep(hits);
+      
+      for(Object* o : hits) {
          if(isToRemove()) {
             return;
          }
          
-         if(collide(it.second)) {
-            printf("Collide with 0x%08X !\n", it.second->getNetId());
-            originSpell->applyEffects(it.second, this);
-         }
+         printf("Collide with 0x%08X !\n", o->getNetId());
+         originSpell->applyEffects(o, this);
       }
    }
    
+}
+
+void Projectile::sweep(std::vector<Object*>& hits) {
+   PROFILE_SCOPE("projectile.sweep");
+   const std::map<uint32, Object*>& objects = map->getObjects();
+   uint64 now = map->getTimers().getTime();
+   uint64 viewTime = now > rewind ? now - rewind : 0;
+   
+   for(auto& it : objects) {
+      float x = it.second->getX(), y = it.second->getY();
+      if(rewind) {
+         map->getHistory().getPosition(it.second->getNetId(), viewTime, x, y);
+      }
+      
+      if(collideAt(it.second, x, y)) {
+         hits.push_back(it.second);
+      }
+   }
 }
\ No newline at end of file
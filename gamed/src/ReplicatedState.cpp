@@ -0,0 +1,55 @@
+#include "ReplicatedState.h"
+
+ReplicatedStats& ReplicatedState::getUnit(uint32 netId) {
+   auto it = units.find(netId);
+   if(it == units.end()) {
+      it = units.insert(std::make_pair(netId, ReplicatedStats())).first;
+      memset(&it->second, 0, sizeof(ReplicatedStats));
+   }
+   return it->second;
+}
+
+void ReplicatedState::recordStat(uint32 netId, uint8 blockId, uint32 field, float value) {
+   ReplicatedStats& sent = getUnit(netId);
+   int block = __builtin_ctz(blockId);
+   sent.known[block] |= field;
+   sent.values[block][__builtin_ctz(field)] = value;
+}
+
+uint8 ReplicatedState::filterStats(uint32 netId, uint8 masterMask, const uint32* masks, const float* values, uint32 outMasks[5], std::vector<float>& outValues) {
+   ReplicatedStats& sent = getUnit(netId);
+   uint8 outMasterMask = 0;
+   outValues.clear();
+
+   for(int i = 0, block = 0; i < 5; ++i) {
+      if(!(masterMask & (1 << i))) {
+         continue;
+      }
+
+      uint32 changed = 0;
+      uint32 first = outValues.size();
+
+      for(uint32 fields = masks[block++]; fields; fields &= fields-1) {
+         uint32 field = __builtin_ctz(fields);
+         float value = *values++;
+
+         if((sent.known[i] & (1 << field)) && sent.values[i][field] == value) {
+            continue;
+         }
+
+         sent.known[i] |= 1 << field;
+         sent.values[i][field] = value;
+         changed |= 1 << field;
+         outValues.push_back(value);
+      }
+
+      if(changed) {
+         outMasks[__builtin_popcount(outMasterMask)] = changed;
+         outMasterMask |= 1 << i;
+      } else {
+         outValues.resize(first);
+      }
+   }
+
+   return outMasterMask;
+}
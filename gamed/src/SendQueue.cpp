@@ -0,0 +1,255 @@
+#include "SendQueue.h"
+#include "common.h"
+#include "Packets.h"
+
+#include <intlib/blowfish.h>
+
+#include <algorithm>
+#include <cstddef>
+
+/* Stats and health packets start with their command and the unit's net id */
+#define PACKET_HEADER_SIZE 5
+#define STATS_FIRST_BLOCK 15 // GamePacket header, then 1, master mask and net id
+
+/**
+ * The class is picked from the channel alone, so that a class never
+ * holds a mix of channels and ENet gets each channel in order
+ */
+SendPriority SendQueue::getPriority(uint8 channel) {
+   switch(channel) {
+   case CHL_HANDSHAKE:
+   case CHL_C2S:
+   case CHL_LOADING_SCREEN:
+      return SEND_CRITICAL;
+   case CHL_S2C:
+      return SEND_HIGH;
+   case CHL_COMMUNICATION:
+      return SEND_LOW;
+   default:
+      return SEND_NORMAL;
+   }
+}
+
+uint64 SendQueue::getKey(const uint8* data, uint32 length) {
+   uint32 netId;
+
+   switch(data[0]) {
+   case PKT_S2C_MoveAns: {
+      // The game header's net id is unused, the unit's one comes after the update count
+      const uint32 offset = offsetof(MovementAns, netId);
+      uint16 nbUpdates;
+      if(length < offset + sizeof(netId)) {
+         return 0;
+      }
+      memcpy(&nbUpdates, data + offsetof(MovementAns, nbUpdates), sizeof(nbUpdates));
+      if(nbUpdates != 1) {
+         return 0;
+      }
+      memcpy(&netId, data+offset, sizeof(netId));
+      break;
+   }
+   case PKT_S2C_CharStats:
+   case PKT_S2C_SetHealth:
+      if(length < PACKET_HEADER_SIZE) {
+         return 0;
+      }
+      memcpy(&netId, data+1, sizeof(netId));
+      break;
+   default:
+      return 0;
+   }
+
+   return ((uint64)data[0] << 32) | netId;
+}
+
+/**
+ * Reads the changed fields of a stats packet in values, newer ones overwriting older ones
+ */
+static bool readStats(const uint8* data, uint32 length, uint32 masks[5], float values[5][32]) {
+   if(length < STATS_FIRST_BLOCK) {
+      return false;
+   }
+
+   uint8 masterMask = data[STATS_FIRST_BLOCK-5];
+   uint32 position = STATS_FIRST_BLOCK;
+
+   for(int i = 0; i < 5; ++i) {
+      if(!(masterMask & (1 << i))) {
+         continue;
+      }
+
+      uint32 mask;
+      if(position + 5 > length) {
+         return false;
+      }
+      memcpy(&mask, data+position, sizeof(mask));
+      position += 5;
+
+      if(position + __builtin_popcount(mask)*4 > length) {
+         return false;
+      }
+
+      masks[i] |= mask;
+      for(uint32 fields = mask; fields; fields &= fields-1) {
+         memcpy(&values[i][__builtin_ctz(fields)], data+position, sizeof(float));
+         position += 4;
+      }
+   }
+
+   return position == length;
+}
+
+/**
+ * Merges a stats packet with the queued one for the same unit, in merged
+ */
+static bool mergeStats(std::vector<uint8>& merged, const ENetPacket* queued, const uint8* data, uint32 length) {
+   uint32 masks[5] = { 0 };
+   float values[5][32];
+
+   if(!readStats(queued->data, queued->dataLength, masks, values) || !readStats(data, length, masks, values)) {
+      return false;
+   }
+
+   uint8 masterMask = 0;
+   for(int i = 0; i < 5; ++i) {
+      if(masks[i]) {
+         masterMask |= 1 << i;
+      }
+   }
+
+   // Keep the newer header, it holds the newer clock
+   merged.assign(data, data + STATS_FIRST_BLOCK);
+   merged[STATS_FIRST_BLOCK-5] = masterMask;
+
+   for(int i = 0; i < 5; ++i) {
+      if(!masks[i]) {
+         continue;
+      }
+
+      merged.insert(merged.end(), (const uint8*)&masks[i], (const uint8*)&masks[i] + sizeof(uint32));
+      merged.push_back(__builtin_popcount(masks[i])*4);
+      for(uint32 fields = masks[i]; fields; fields &= fields-1) {
+         const float* value = &values[i][__builtin_ctz(fields)];
+         merged.insert(merged.end(), (const uint8*)value, (const uint8*)value + sizeof(float));
+      }
+   }
+
+   return true;
+}
+
+/**
+ * Overwrites the bytes of a queued packet, growing it from the pool if needed
+ */
+static bool rewrite(ENetPacket* packet, const uint8* data, uint32 length) {
+   if(enet_packet_resize(packet, length) < 0) {
+      return false;
+   }
+   memcpy(packet->data, data, length);
+   return true;
+}
+
+SendQueue::~SendQueue() {
+   for(int priority = 0; priority < SEND_PRIORITIES; ++priority) {
+      for(OutboundPacket& packet : queues[priority]) {
+         enet_packet_destroy(packet.packet);
+      }
+   }
+}
+
+void SendQueue::push(const uint8* data, uint32 length, uint8 channel, uint32 flags) {
+   SendPriority priority = getPriority(channel);
+   uint64 key = getKey(data, length);
+
+   if(key) {
+      auto it = pending.find(key);
+      if(it != pending.end()) {
+         ENetPacket* queued = it->second->packet;
+         uint32 queuedLength = queued->dataLength;
+
+         if(data[0] != PKT_S2C_CharStats) {
+            // The newest path or health replaces the old one
+            if(rewrite(queued, data, length)) {
+               queuedBytes += length - queuedLength;
+               return;
+            }
+         } else if(mergeStats(merged, queued, data, length) && rewrite(queued, &merged[0], merged.size())) {
+            queuedBytes += merged.size() - queuedLength;
+            return;
+         }
+
+         // Couldn't merge, the old packet goes as is
+         it->second->key = 0;
+         pending.erase(it);
+      }
+   }
+
+   ENetPacket* p = enet_packet_create(data, length, flags);
+   if(!p) {
+      return;
+   }
+
+   OutboundPacket packet = { p, channel, key };
+   queues[priority].push_back(packet);
+   queuedBytes += length;
+
+   if(key) {
+      pending[key] = &queues[priority].back();
+   }
+}
+
+void SendQueue::take(ENetPeer* peer, uint32 elapsed, std::vector<OutboundPacket>& out) {
+   uint32 bandwidth = peer->incomingBandwidth ? peer->incomingBandwidth : SEND_DEFAULT_BANDWIDTH;
+   bandwidth = (uint64)bandwidth * peer->packetThrottle / ENET_PEER_PACKET_THROTTLE_SCALE;
+
+   // Unused budget is kept for about one round trip, not more
+   int32 burst = (uint64)bandwidth * std::max<uint32>(peer->roundTripTime, SEND_MIN_BURST) / 1000;
+   credit = std::min<int32>(credit + (int32)((uint64)bandwidth*elapsed/1000), burst);
+
+   for(int priority = 0; priority < SEND_PRIORITIES; ++priority) {
+      PacketDeque& queue = queues[priority];
+
+      while(!queue.empty() && (priority == SEND_CRITICAL || credit > 0)) {
+         OutboundPacket& packet = queue.front();
+         uint32 length = packet.packet->dataLength;
+
+         credit -= length;
+         queuedBytes -= length;
+         if(packet.key) {
+            pending.erase(packet.key);
+         }
+         out.push_back(packet);
+         queue.pop_front();
+      }
+
+      // Lower classes never pass a waiting higher one
+      if(!queue.empty()) {
+         break;
+      }
+   }
+}
+
+void SendQueue::encrypt(OutboundPacket& packet, BlowFish* blowfish) {
+   uint32 length = packet.packet->dataLength;
+   if(length >= 8) {
+      blowfish->Encrypt(packet.packet->data, length-(length%8)); //Encrypt everything minus the last bytes that overflow the 8 byte boundary
+   }
+}
+
+bool SendQueue::send(ENetPeer* peer, OutboundPacket* packets, uint32 count) {
+   bool ok = true;
+
+   for(uint32 i = 0; i < count; ++i) {
+      if(enet_peer_send(peer, packets[i].channel, packets[i].packet) < 0) {
+         enet_packet_destroy(packets[i].packet);
+         ok = false;
+      }
+   }
+
+   return ok;
+}
+
+void SendQueue::discard(OutboundPacket* packets, uint32 count) {
+   for(uint32 i = 0; i < count; ++i) {
+      enet_packet_destroy(packets[i].packet);
+   }
+}
@@ -0,0 +1,138 @@
+#include "Snapshot.h"
+#include "TimerWheel.h"
+#include "Game.h"
+
+#include <sys/time.h>
+
+using namespace std;
+
+SnapshotWriter::SnapshotWriter() {
+   buffer.reserve(256*1024);
+
+   SnapshotHeader header = { SNAPSHOT_MAGIC, SNAPSHOT_VERSION, 0, 0 };
+   put(header);
+}
+
+void SnapshotWriter::put(const void* data, uint32 length) {
+   buffer.insert(buffer.end(), (const uint8*)data, (const uint8*)data + length);
+}
+
+void SnapshotWriter::putString(const string& s) {
+   put((uint16)s.length());
+   put(s.c_str(), s.length());
+}
+
+void SnapshotWriter::putTimer(const Timer& timer) {
+   put(timer.isScheduled() ? timer.getRemaining() : (uint32)SNAPSHOT_NO_TIMER);
+}
+
+bool SnapshotWriter::save(const string& fileName) {
+   ((SnapshotHeader*)&buffer[0])->size = buffer.size();
+
+   FILE* file = fopen(fileName.c_str(), "wb");
+   if(!file) {
+      printf("Couldn't open %s\n", fileName.c_str());
+      return false;
+   }
+
+   bool ok = fwrite(&buffer[0], 1, buffer.size(), file) == buffer.size();
+   return (fclose(file) == 0) && ok;
+}
+
+bool SnapshotReader::open(const string& fileName) {
+   FILE* file = fopen(fileName.c_str(), "rb");
+   if(!file) {
+      printf("Couldn't open %s\n", fileName.c_str());
+      return false;
+   }
+
+   SnapshotHeader header;
+   if(fread(&header, sizeof(header), 1, file) != 1 || header.magic != SNAPSHOT_MAGIC || header.size < sizeof(header)) {
+      printf("%s is not a snapshot\n", fileName.c_str());
+      fclose(file);
+      return false;
+   }
+
+   if(header.version != SNAPSHOT_VERSION) {
+      printf("%s has version %u, expected %u\n", fileName.c_str(), header.version, SNAPSHOT_VERSION);
+      fclose(file);
+      return false;
+   }
+
+   buffer.resize(header.size - sizeof(header));
+   bool ok = buffer.empty() || fread(&buffer[0], 1, buffer.size(), file) == buffer.size();
+   fclose(file);
+
+   if(!ok) {
+      printf("%s is truncated\n", fileName.c_str());
+   }
+   return ok;
+}
+
+void SnapshotReader::get(void* data, uint32 length) {
+   if(failed || position + length > buffer.size()) {
+      failed = true;
+      memset(data, 0, length);
+      return;
+   }
+
+   memcpy(data, &buffer[position], length);
+   position += length;
+}
+
+string SnapshotReader::getString() {
+   uint16 length = get<uint16>();
+   if(failed || position + length > buffer.size()) {
+      failed = true;
+      return "";
+   }
+
+   string s((const char*)&buffer[position], length);
+   position += length;
+   return s;
+}
+
+void SnapshotReader::getTimer(Timer& timer, TimerWheel& wheel) {
+   uint32 remaining = get<uint32>();
+   if(remaining != SNAPSHOT_NO_TIMER && !failed) {
+      wheel.schedule(&timer, remaining);
+   }
+}
+
+bool Game::saveSnapshot(const char *fileName)
+{
+   struct timeval tStart, tEnd, tDiff;
+   gettimeofday(&tStart, 0);
+   
+   SnapshotWriter s;
+   s.put(_tick);
+   s.put(_started);
+   s.put(map->peekNetId());
+   map->save(s);
+   
+   gettimeofday(&tEnd, 0);
+   timersub(&tEnd, &tStart, &tDiff);
+   printf("Snapshot of %u bytes taken in %ld us\n", s.size(), tDiff.tv_sec*1000000 + tDiff.tv_usec);
+   
+   return s.save(fileName);
+}
+
+bool Game::restoreSnapshot(const char *fileName)
+{
+   SnapshotReader s;
+   if(!s.open(fileName))
+      return false;
+   
+   _tick = s.get<uint32>();
+   _started = s.get<bool>();
+   uint32 nextNetId = s.get<uint32>();
+   
+   if(!map->load(s, _restoredChampions) || !s.isValid() || !s.isAtEnd()) {
+      printf("%s is corrupted\n", fileName);
+      return false;
+   }
+   
+   map->setNextNetId(nextNetId);
+   printf("Restored tick %u from %s\n", _tick, fileName);
+   return true;
+}
@@ -0,0 +1,42 @@
+#include "SpatialIndex.h"
+#include "Turret.h"
+
+#include <algorithm>
+
+void SpatialIndex::add(Unit* u) {
+   SpatialEntry e = { u, u->getX(), u->getY(), u->getSide(), u->getKind() };
+   uint16 cell = toCell(e.y)*SPATIAL_GRID_SIZE + toCell(e.x);
+
+   unsorted.push_back(e);
+   unsortedCells.push_back(cell);
+   ++cellStart[cell];
+}
+
+void SpatialIndex::rebuild(const std::map<uint32, Object*>& objects, Turret* turrets, uint32 turretCount) {
+   unsorted.clear();
+   unsortedCells.clear();
+   std::fill(cellStart.begin(), cellStart.end(), 0);
+
+   for(auto& kv : objects) {
+      Unit* u = dynamic_cast<Unit*>(kv.second);
+      if(u && !u->isToRemove()) {
+         add(u);
+      }
+   }
+
+   for(uint32 i = 0; i < turretCount; ++i) {
+      if(turrets[i].getStats().getCurrentHealth() > 0) {
+         add(&turrets[i]);
+      }
+   }
+
+   for(uint32 i = 1; i < cellStart.size(); ++i) {
+      cellStart[i] += cellStart[i-1];
+   }
+
+   // cellStart now holds each cell's end, filling backwards turns it into starts
+   entries.resize(unsorted.size());
+   for(uint32 i = unsorted.size(); i > 0; --i) {
+      entries[--cellStart[unsortedCells[i-1]]] = unsorted[i-1];
+   }
+}
@@ -1,11 +1,14 @@
 #include "Spell.h"
+#include "Champion.h"
+#include "Map.h"
+#include "Snapshot.h"
 
 /**
  * Called when the character casts the spell
  */
 bool Spell::cast(float x, float y, Unit* u) {
    state = STATE_CASTING;
-   currentCastTime = castTime;
+   owner->getMap()->getTimers().schedule(this, castTime*1000);
    
    this->x = x;
    this->y = y;
@@ -20,27 +23,38 @@ bool Spell::cast(float x, float y, Unit* u) {
  */
 void Spell::finishCasting() {
    state = STATE_COOLDOWN;
-   currentCooldown = getCooldown();
+   owner->getMap()->getTimers().schedule(this, getCooldown()*1000);
 }
 
 /**
- * Called every diff milliseconds to update the spell
+ * Called by the game's timers when the cast or the cooldown ends
  */
-void Spell::update(unsigned int diff) {
+void Spell::onTimer() {
    switch(state) {
       case STATE_READY:
          return;
       case STATE_CASTING:
-         currentCastTime -= diff/1000.f;
-         if(currentCastTime < 0) {
-            finishCasting();
-         }
+         finishCasting();
          break;
       case STATE_COOLDOWN:
-         currentCooldown -= diff/1000.f;
-         if(currentCooldown < 0) {
-            state = STATE_READY;
-         }
+         state = STATE_READY;
          break;
    }
-}
\ No newline at end of file
+}
+
+void Spell::save(SnapshotWriter& s) const {
+   s.put(level);
+   s.put((uint8)state);
+   s.put(x);
+   s.put(y);
+   s.putTimer(*this);
+}
+
+void Spell::load(SnapshotReader& s) {
+   level = s.get<uint8>();
+   state = (SpellState)s.get<uint8>();
+   x = s.get<float>();
+   y = s.get<float>();
+   target = 0;
+   s.getTimer(*this, owner->getMap()->getTimers());
+}
@@ -0,0 +1,297 @@
+#include "StatModifiers.h"
+#include "Snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+/**
+ * Edges from an attribute to the replicated fields derived from it.
+ * baseField holds the unmodified value and is never touched by modifiers,
+ * totalField receives the final value, flatField and percentField receive
+ * the bonuses for the fields the client combines itself.
+ */
+struct AttributeFields {
+   uint8 block;
+   uint32 baseField;
+   uint32 totalField;
+   uint32 flatField;
+   uint32 percentField;
+   float defaultBase;
+};
+
+static const AttributeFields attributeFields[ATTR_COUNT] = {
+   { MM_Two,  FM2_Base_Ad, 0,                 FM2_Bonus_Ad_Flat, FM2_Bonus_Ad_Pct, 0 }, // ATTR_ATTACK_DAMAGE
+   { MM_Two,  FM2_Base_Ap, 0,                 FM2_Bonus_Ap_Flat, 0,                0 }, // ATTR_ABILITY_POWER
+   { MM_Two,  0,           FM2_Bonus_Ats,     0,                 0,                1 }, // ATTR_ATTACK_SPEED
+   { MM_Two,  0,           FM2_Crit_Chance,   0,                 0,                0 }, // ATTR_CRIT_CHANCE
+   { MM_Two,  0,           FM2_Armor,         0,                 0,                0 }, // ATTR_ARMOR
+   { MM_Two,  0,           FM2_Magic_Armor,   0,                 0,                0 }, // ATTR_MAGIC_ARMOR
+   { MM_Two,  0,           FM2_Hp5,           0,                 0,                0 }, // ATTR_HP5
+   { MM_Two,  0,           FM2_Mp5,           0,                 0,                0 }, // ATTR_MP5
+   { MM_Two,  0,           FM2_Range,         0,                 0,                0 }, // ATTR_RANGE
+   { MM_Two,  0,           FM2_cdr,           0,                 0,                0 }, // ATTR_COOLDOWN_REDUCTION
+   { MM_Four, 0,           0,                 0,                 0,                0 }, // ATTR_MAX_HEALTH, field depends on the unit type
+   { MM_Four, 0,           FM4_Speed,         0,                 0,                0 }, // ATTR_MOVEMENT_SPEED
+};
+
+void ModifierExpiry::onTimer() {
+   owner->removeModifier(handle);
+}
+
+StatModifiers::StatModifiers(Stats* stats, TimerWheel* timers) : stats(stats), timers(timers), nextHandle(1), knownBase(0), dirty(0) {
+   memset(base, 0, sizeof(base));
+   memset(flat, 0, sizeof(flat));
+   memset(percent, 0, sizeof(percent));
+   memset(overrideValue, 0, sizeof(overrideValue));
+   memset(overrideCount, 0, sizeof(overrideCount));
+}
+
+/**
+ * The first time an attribute gets modified, whatever the unit's Stats hold
+ * becomes its base value
+ */
+void StatModifiers::captureBase(StatAttribute attr) {
+   if(knownBase & (1 << attr)) {
+      return;
+   }
+
+   knownBase |= (1 << attr);
+   base[attr] = getBaseValue(attr);
+}
+
+float StatModifiers::getBaseValue(StatAttribute attr) const {
+   if(knownBase & (1 << attr)) {
+      return base[attr];
+   }
+
+   const AttributeFields& f = attributeFields[attr];
+
+   if(attr == ATTR_MAX_HEALTH) {
+      return stats->getMaxHealth();
+   }
+   if(f.baseField) {
+      return stats->getStat(f.block, f.baseField);
+   }
+   if(f.totalField && stats->getStat(f.block, f.totalField) != 0) {
+      return stats->getStat(f.block, f.totalField);
+   }
+
+   return f.defaultBase;
+}
+
+void StatModifiers::setBaseValue(StatAttribute attr, float value) {
+   knownBase |= (1 << attr);
+   base[attr] = value;
+
+   if(attributeFields[attr].baseField) {
+      writeField(attributeFields[attr].block, attributeFields[attr].baseField, value);
+   }
+
+   dirty |= (1 << attr);
+}
+
+float StatModifiers::getTotal(StatAttribute attr) const {
+   if(!(knownBase & (1 << attr))) {
+      return getBaseValue(attr);
+   }
+
+   if(overrideCount[attr]) {
+      return overrideValue[attr];
+   }
+
+   return (base[attr] + flat[attr]) * (1.f + percent[attr]);
+}
+
+uint32 StatModifiers::addModifier(uint32 source, StatAttribute attr, ModifierType type, float value, uint32 duration) {
+   captureBase(attr);
+
+   uint32 handle = nextHandle++;
+   StatModifier& m = modifiers[handle];
+   m.source = source;
+   m.attribute = attr;
+   m.type = type;
+   m.value = value;
+
+   switch(type) {
+   case MODIFIER_FLAT:
+      flat[attr] += value;
+      break;
+   case MODIFIER_PERCENT:
+      percent[attr] += value;
+      break;
+   case MODIFIER_OVERRIDE:
+      ++overrideCount[attr];
+      overrideValue[attr] = value; // The latest override wins
+      break;
+   }
+
+   if(duration) {
+      m.expiry.owner = this;
+      m.expiry.handle = handle;
+      timers->schedule(&m.expiry, duration);
+   }
+
+   dirty |= (1 << attr);
+   return handle;
+}
+
+/**
+ * Only called when an override is removed while others remain, which is rare
+ * enough that walking the modifiers is fine
+ */
+void StatModifiers::refreshOverride(StatAttribute attr) {
+   uint32 latest = 0;
+
+   for(auto& kv : modifiers) {
+      if(kv.second.attribute == attr && kv.second.type == MODIFIER_OVERRIDE) {
+         latest = kv.first;
+      }
+   }
+
+   if(latest) {
+      overrideValue[attr] = modifiers[latest].value;
+   }
+}
+
+bool StatModifiers::removeModifier(uint32 handle) {
+   auto it = modifiers.find(handle);
+   if(it == modifiers.end()) {
+      return false;
+   }
+
+   StatAttribute attr = it->second.attribute;
+   ModifierType type = it->second.type;
+   float value = it->second.value;
+   modifiers.erase(it); // Also cancels the expiry
+
+   switch(type) {
+   case MODIFIER_FLAT:
+      flat[attr] -= value;
+      break;
+   case MODIFIER_PERCENT:
+      percent[attr] -= value;
+      break;
+   case MODIFIER_OVERRIDE:
+      if(--overrideCount[attr]) {
+         refreshOverride(attr);
+      }
+      break;
+   }
+
+   dirty |= (1 << attr);
+   return true;
+}
+
+void StatModifiers::removeModifiersFrom(uint32 source) {
+   for(auto it = modifiers.begin(); it != modifiers.end();) {
+      uint32 handle = it->first;
+      bool match = it->second.source == source;
+      ++it;
+
+      if(match) {
+         removeModifier(handle);
+      }
+   }
+}
+
+void StatModifiers::writeField(uint8 blockId, uint32 field, float value) {
+   if(stats->getStat(blockId, field) != value) {
+      stats->setStat(blockId, field, value);
+   }
+}
+
+void StatModifiers::recompute(StatAttribute attr) {
+   const AttributeFields& f = attributeFields[attr];
+   float total = getTotal(attr);
+
+   if(attr == ATTR_MAX_HEALTH) {
+      // Current health follows max health changes, like a freshly bought item
+      float delta = total - stats->getMaxHealth();
+      if(delta != 0) {
+         stats->setMaxHealth(total);
+         stats->setCurrentHealth(max(0.f, min(total, stats->getCurrentHealth() + delta)));
+      }
+      return;
+   }
+
+   if(f.totalField) {
+      writeField(f.block, f.totalField, total);
+   }
+
+   if(f.flatField) {
+      if(f.percentField && !overrideCount[attr]) {
+         writeField(f.block, f.flatField, flat[attr]);
+      } else {
+         writeField(f.block, f.flatField, total - base[attr]);
+      }
+   }
+
+   if(f.percentField) {
+      writeField(f.block, f.percentField, overrideCount[attr] ? 0 : percent[attr]);
+   }
+}
+
+void StatModifiers::update() {
+   if(!dirty) {
+      return;
+   }
+
+   for(uint32 pending = dirty; pending; pending &= pending-1) {
+      recompute((StatAttribute)__builtin_ctz(pending));
+   }
+
+   dirty = 0;
+}
+
+void StatModifiers::save(SnapshotWriter& s) const {
+   s.put(base, sizeof(base));
+   s.put(flat, sizeof(flat));
+   s.put(percent, sizeof(percent));
+   s.put(overrideValue, sizeof(overrideValue));
+   s.put(overrideCount, sizeof(overrideCount));
+   s.put(knownBase);
+   s.put(dirty);
+   s.put(nextHandle);
+
+   s.put((uint32)modifiers.size());
+   for(auto& kv : modifiers) {
+      const StatModifier& m = kv.second;
+      s.put(kv.first);
+      s.put(m.source);
+      s.put(m.attribute);
+      s.put(m.type);
+      s.put(m.value);
+      s.putTimer(m.expiry);
+   }
+}
+
+/**
+ * The aggregates are restored as they were, so the Stats fields derived
+ * from them don't need recomputing
+ */
+void StatModifiers::load(SnapshotReader& s) {
+   s.get(base, sizeof(base));
+   s.get(flat, sizeof(flat));
+   s.get(percent, sizeof(percent));
+   s.get(overrideValue, sizeof(overrideValue));
+   s.get(overrideCount, sizeof(overrideCount));
+   knownBase = s.get<uint32>();
+   dirty = s.get<uint32>();
+   nextHandle = s.get<uint32>();
+
+   modifiers.clear();
+   uint32 count = s.get<uint32>();
+   for(uint32 i = 0; i < count && s.isValid(); ++i) {
+      uint32 handle = s.get<uint32>();
+      StatModifier& m = modifiers[handle];
+      m.source = s.get<uint32>();
+      m.attribute = s.get<StatAttribute>();
+      m.type = s.get<ModifierType>();
+      m.value = s.get<float>();
+      m.expiry.owner = this;
+      m.expiry.handle = handle;
+      s.getTimer(m.expiry, *timers);
+   }
+}
@@ -1,29 +1,36 @@
 #include "Stats.h"
+#include "Snapshot.h"
 
 using namespace std;
 
-float Stats::getStat(uint8 blockId, uint32 stat) const {
-   int block = -1;
-   while(blockId) {
-      blockId = blockId >> 1;
-      ++block;
-   }
-   auto it = stats[block].find(stat);
-   if(it != stats[block].end()) {
-      return it->second;
+uint8 Stats::getUpdatedMasterMask() const {
+   uint8 masterMask = 0;
+   
+   for(int i = 0; i < 5; ++i) {
+      if(updatedStats[i]) {
+         masterMask |= (1 << i);
+      }
    }
    
-   return 0;
+   return masterMask;
 }
 
-void Stats::setStat(uint8 blockId, uint32 stat, float value) {
-   int block = -1;
-   updatedStats.insert(make_pair(blockId, stat));
-   
-   while(blockId) {
-      blockId = blockId >> 1;
-      ++block;
+void Stats::markAllUpdated() {
+   for(int i = 0; i < 5; ++i) {
+      for(int j = 0; j < 32; ++j) {
+         if(stats[i][j] != 0) {
+            updatedStats[i] |= 1 << j;
+         }
+      }
    }
-   stats[block][stat] = value;
 }
 
+void Stats::save(SnapshotWriter& s) const {
+   s.put(stats, sizeof(stats));
+   s.put(updatedStats, sizeof(updatedStats));
+}
+
+void Stats::load(SnapshotReader& s) {
+   s.get(stats, sizeof(stats));
+   s.get(updatedStats, sizeof(updatedStats));
+}
@@ -0,0 +1,95 @@
+#include "Targeting.h"
+#include "Unit.h"
+
+#include <algorithm>
+
+using namespace std;
+
+bool PriorityClosest(const TargetCandidate& a, const TargetCandidate& b) {
+   return a.distanceSq < b.distanceSq;
+}
+
+static int getLaneRank(uint8 kind) {
+   switch(kind) {
+   case UNIT_MINION:
+      return 0;
+   case UNIT_TURRET:
+      return 1;
+   default:
+      return 2;
+   }
+}
+
+bool PriorityLaneRules(const TargetCandidate& a, const TargetCandidate& b) {
+   int rankA = getLaneRank(a.kind), rankB = getLaneRank(b.kind);
+   if(rankA != rankB) {
+      return rankA < rankB;
+   }
+
+   return a.distanceSq < b.distanceSq;
+}
+
+uint32 Targeting::query(const TargetQuery& q, Unit** out) {
+   candidates.resize(1);
+   return answer(q, out, candidates[0]);
+}
+
+uint32 Targeting::answer(const TargetQuery& q, Unit** out, vector<TargetCandidate>& candidates) const {
+   candidates.clear();
+
+   index.forEachInRadius(q.x, q.y, q.radius, [&](const SpatialEntry& e, float distanceSq) {
+      if(!(e.kind & q.kinds) || (e.side != q.side) != q.enemies || e.unit == q.exclude) {
+         return;
+      }
+      if(e.unit->getStats().getCurrentHealth() <= 0) {
+         return;
+      }
+
+      TargetCandidate c = { e.unit, distanceSq, e.kind };
+      candidates.push_back(c);
+   });
+
+   uint32 count = min((uint32)candidates.size(), (uint32)min(q.maxResults, (uint8)TARGET_MAX_RESULTS));
+   partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), q.priority);
+
+   for(uint32 i = 0; i < count; ++i) {
+      out[i] = candidates[i].unit;
+   }
+
+   return count;
+}
+
+void Targeting::submit(const TargetQuery& query, TargetListener* listener) {
+   PendingQuery p = { query, listener };
+   pending.push_back(p);
+}
+
+void Targeting::cancel(TargetListener* listener) {
+   for(uint32 i = 0; i < pending.size(); ) {
+      if(pending[i].listener == listener) {
+         pending.erase(pending.begin() + i);
+      } else {
+         ++i;
+      }
+   }
+}
+
+void Targeting::process(JobSystem& jobs) {
+   // Listeners may submit new queries, those wait for the next tick
+   uint32 count = pending.size();
+   results.resize(count);
+   candidates.resize(jobs.getWorkerCount());
+
+   auto answerRange = [this](uint32 begin, uint32 end, uint32 worker) {
+      for(uint32 i = begin; i < end; ++i) {
+         results[i].count = answer(pending[i].query, results[i].targets, candidates[worker]);
+      }
+   };
+   jobs.parallelFor(count, 32, answerRange);
+
+   for(uint32 i = 0; i < count; ++i) {
+      pending[i].listener->onTargetsFound(results[i].targets, results[i].count);
+   }
+
+   pending.erase(pending.begin(), pending.begin() + count);
+}
@@ -0,0 +1,183 @@
+#include "TimerWheel.h"
+
+void Timer::cancel() {
+   if(wheel) {
+      wheel->cancel(this);
+   }
+}
+
+uint32 Timer::getRemaining() const {
+   if(!wheel || expires <= wheel->getTime()) {
+      return 0;
+   }
+
+   return expires - wheel->getTime();
+}
+
+static void initList(TimerNode* head) {
+   head->next = head->prev = head;
+}
+
+TimerWheel::TimerWheel() : time(0), tick(1), rootCount(0), count(0) {
+   for(int i = 0; i < TIMER_ROOT_SIZE; ++i) {
+      initList(&root[i]);
+   }
+
+   for(int l = 0; l < TIMER_LEVELS-1; ++l) {
+      for(int i = 0; i < TIMER_LEVEL_SIZE; ++i) {
+         initList(&levels[l][i]);
+      }
+   }
+}
+
+/**
+ * Puts a timer in the slot matching its distance from the next tick
+ */
+void TimerWheel::place(Timer* t) {
+   uint64 expires = t->expires < tick ? tick : t->expires;
+   uint64 delta = expires - tick;
+   TimerNode* head;
+
+   if(delta < TIMER_ROOT_SIZE) {
+      t->level = 0;
+      head = &root[expires & (TIMER_ROOT_SIZE-1)];
+      ++rootCount;
+   } else {
+      if(delta > TIMER_MAX_DELAY) {
+         expires = tick + TIMER_MAX_DELAY; // Goes back up when cascaded
+      }
+
+      int level = 1;
+      while(level < TIMER_LEVELS-1 && delta >= (1ULL << (TIMER_ROOT_BITS + level*TIMER_LEVEL_BITS))) {
+         ++level;
+      }
+
+      t->level = level;
+      head = &levels[level-1][(expires >> (TIMER_ROOT_BITS + (level-1)*TIMER_LEVEL_BITS)) & (TIMER_LEVEL_SIZE-1)];
+   }
+
+   TimerNode* node = t;
+   node->prev = head->prev;
+   node->next = head;
+   head->prev->next = node;
+   head->prev = node;
+}
+
+void TimerWheel::unlink(Timer* t) {
+   TimerNode* node = t;
+   node->prev->next = node->next;
+   node->next->prev = node->prev;
+   node->next = node->prev = 0;
+
+   if(t->level == 0) {
+      --rootCount;
+   }
+}
+
+void TimerWheel::schedule(Timer* t, uint32 delay) {
+   if(t->wheel) {
+      t->wheel->cancel(t);
+   }
+
+   t->wheel = this;
+   t->expires = time + delay;
+   ++count;
+   place(t);
+}
+
+void TimerWheel::cancel(Timer* t) {
+   if(t->wheel != this) {
+      return;
+   }
+
+   unlink(t);
+   t->wheel = 0;
+   --count;
+}
+
+/**
+ * Moves the timers of the current slot of a level down to finer levels
+ */
+void TimerWheel::cascade(int level) {
+   int index = (tick >> (TIMER_ROOT_BITS + (level-1)*TIMER_LEVEL_BITS)) & (TIMER_LEVEL_SIZE-1);
+   TimerNode* head = &levels[level-1][index];
+
+   if(index == 0 && level < TIMER_LEVELS-1) {
+      cascade(level+1);
+   }
+
+   TimerNode pending;
+   if(head->next == head) {
+      return;
+   }
+
+   pending.next = head->next;
+   pending.prev = head->prev;
+   pending.next->prev = &pending;
+   pending.prev->next = &pending;
+   initList(head);
+
+   while(pending.next != &pending) {
+      Timer* t = static_cast<Timer*>(pending.next);
+      unlink(t);
+      place(t);
+   }
+}
+
+void TimerWheel::update(unsigned int diff) {
+   uint64 target = time + diff;
+
+   while(tick <= target) {
+      int index = tick & (TIMER_ROOT_SIZE-1);
+
+      if(index == 0 && count > rootCount) {
+         cascade(1);
+      }
+
+      // Nothing can expire before the next cascade, jump straight to it
+      if(rootCount == 0) {
+         uint64 next = (tick | (TIMER_ROOT_SIZE-1)) + 1;
+         if(count == 0 || next > target) {
+            tick = target+1;
+            break;
+         }
+         tick = next;
+         continue;
+      }
+
+      TimerNode* head = &root[index];
+      time = tick++;
+
+      // Detach the slot first, callbacks may schedule timers again
+      TimerNode expired;
+      if(head->next == head) {
+         continue;
+      }
+
+      expired.next = head->next;
+      expired.prev = head->prev;
+      expired.next->prev = &expired;
+      expired.prev->next = &expired;
+      initList(head);
+
+      while(expired.next != &expired) {
+         Timer* t = static_cast<Timer*>(expired.next);
+         unlink(t);
+         t->wheel = 0;
+         --count;
+         t->onTimer();
+      }
+   }
+
+   time = target;
+}
+
+bool TimerWheel::setTime(uint64 time) {
+   if(count) {
+      return false;
+   }
+
+   this->time = time;
+   tick = time+1;
+   return true;
+}
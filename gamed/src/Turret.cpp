@@ -0,0 +1,105 @@
+#include "Turret.h"
+#include "MinionStats.h"
+#include "Map.h"
+#include "Snapshot.h"
+
+/**
+ * Summoner's Rift turrets, in the order the client expects them
+ */
+const TurretInfo Turret::turretInfos[TURRET_COUNT] = {
+   { "@Turret_T1_R_03_A",           10097.62f,   808.73f, 0, 2000.f },
+   { "@Turret_T1_R_02_A",            6512.53f,  1262.62f, 0, 2000.f },
+   { "@Turret_T1_C_07_A",            3747.26f,  1041.04f, 0, 2000.f },
+   { "@Turret_T2_R_03_A",           13866.24f,  4505.23f, 1, 2000.f },
+   { "@Turret_T2_R_02_A",           13327.42f,  8226.28f, 1, 2000.f },
+   { "@Turret_T2_R_01_A",           13624.75f, 10572.77f, 1, 2000.f },
+   { "@Turret_T1_C_05_A",            5448.02f,  6169.10f, 0, 2000.f },
+   { "@Turret_T1_C_04_A",            4657.66f,  4591.91f, 0, 2000.f },
+   { "@Turret_T1_C_03_A",            3233.99f,  3447.24f, 0, 2000.f },
+   { "@Turret_T1_C_01_A",            1341.63f,  2029.98f, 0, 2500.f },
+   { "@Turret_T1_C_02_A",            1768.19f,  1589.47f, 0, 2500.f },
+   { "@Turret_T2_C_05_A",            8548.80f,  8289.50f, 1, 2000.f },
+   { "@Turret_T2_C_04_A",            9361.07f,  9892.62f, 1, 2000.f },
+   { "@Turret_T2_C_03_A",           10743.58f, 11010.06f, 1, 2000.f },
+   { "@Turret_T2_C_01_A",           13052.92f, 12612.38f, 1, 2500.f },
+   { "@Turret_T2_C_02_A",           12611.18f, 13084.11f, 1, 2500.f },
+   { "@Turret_OrderTurretShrine_A",  -236.05f,   -53.32f, 0, 9999.f },
+   { "@Turret_ChaosTurretShrine_A", 14157.00f, 14456.00f, 1, 9999.f },
+   { "@Turret_T1_L_03_A",             574.66f, 10220.47f, 0, 2000.f },
+   { "@Turret_T1_L_02_A",            1106.26f,  6485.25f, 0, 2000.f },
+   { "@Turret_T1_C_06_A",             802.81f,  4052.36f, 0, 2000.f },
+   { "@Turret_T2_L_03_A",            3911.67f, 13654.81f, 1, 2000.f },
+   { "@Turret_T2_L_02_A",            7536.52f, 13190.81f, 1, 2000.f },
+   { "@Turret_T2_L_01_A",           10261.90f, 13465.91f, 1, 2000.f }
+};
+
+/* Turrets share the minions' field layout */
+Turret::Turret(Map* map, uint32 id, const TurretInfo& info) : Unit(map, id, new MinionStats(), info.x, info.y), name(info.name), targetId(0) {
+   setSide(info.side);
+   stats->setCurrentHealth(info.health);
+   stats->setMaxHealth(info.health);
+   stats->setBaseAd(152.f);
+   stats->setRange(TURRET_RANGE);
+   autoAttack.setBaseSpeed(TURRET_ATTACK_SPEED);
+}
+
+Turret::~Turret() {
+   map->getTargeting().cancel(this);
+}
+
+void Turret::activate() {
+   map->getTimers().schedule(this, TURRET_SCAN_DELAY);
+}
+
+void Turret::attack(Unit* target) {
+   targetId = target->getNetId();
+   autoAttack.start(target);
+   map->getTimers().schedule(this, TURRET_SCAN_DELAY);
+}
+
+/**
+ * Keeps shooting the same target while it stays in range, only looks for
+ * a new one once it's gone
+ */
+void Turret::onTimer() {
+   if(stats->getCurrentHealth() <= 0) {
+      autoAttack.stop();
+      return;
+   }
+
+   Unit* target = targetId ? dynamic_cast<Unit*>(map->getObjectById(targetId)) : 0;
+   if(target && target->getStats().getCurrentHealth() > 0 && distanceWith(target) <= TURRET_RANGE) {
+      attack(target);
+      return;
+   }
+
+   targetId = 0;
+   autoAttack.stop();
+   TargetQuery query(x, y, TURRET_RANGE, side, UNIT_CHAMPION | UNIT_MINION, 1, PriorityLaneRules);
+   map->getTargeting().submit(query, this);
+}
+
+void Turret::onTargetsFound(Unit** targets, uint32 count) {
+   if(count) {
+      attack(targets[0]);
+   } else {
+      map->getTimers().schedule(this, TURRET_SCAN_DELAY);
+   }
+}
+
+void Turret::die(Unit* killer) {
+   Unit::die(killer);
+   Timer::cancel();
+}
+
+void Turret::save(SnapshotWriter& s) const {
+   Unit::save(s);
+   s.put(targetId);
+   s.putTimer(*this);
+}
+
+void Turret::load(SnapshotReader& s) {
+   Unit::load(s);
+   targetId = s.get<uint32>();
+   s.getTimer(*this, map->getTimers());
+}
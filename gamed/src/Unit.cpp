@@ -1,10 +1,15 @@
 #include "Unit.h"
 #include "AI.h"
+#include "Map.h"
+#include "Snapshot.h"
 
 #include <algorithm>
 
 using namespace std;
 
+Unit::Unit(Map* map, uint32 id, Stats* stats, float x, float y, AI* ai) : Object(map, id, x, y, 40, 40), stats(stats), modifiers(stats, &map->getTimers()), ai(ai), autoAttack(this) {
+}
+
 Unit::~Unit() {
    delete stats;
    if(ai) {
@@ -12,6 +17,11 @@ Unit::~Unit() {
    }
 }
 
+void Unit::integrate(unsigned int diff) {
+   Object::integrate(diff);
+   modifiers.update();
+}
+
 void Unit::update(unsigned int diff) {
    Object::update(diff);
    
@@ -21,5 +31,32 @@ void Unit::update(unsigned int diff) {
 }
 
 void Unit::dealDamageTo(Unit* target, float damage, DamageType type, DamageSource source) {
-   target->getStats().setCurrentHealth(max(0.f, target->getStats().getCurrentHealth()-damage));
-}
\ No newline at end of file
+   map->getDamage().push(this, target, damage, type, source);
+}
+
+void Unit::die(Unit*) {
+   autoAttack.stop();
+   setWaypoints(vector<MovementVector>(1, MovementVector((x - MAP_WIDTH)/2, (y - MAP_HEIGHT)/2)));
+}
+
+void Unit::save(SnapshotWriter& s) const {
+   Object::save(s);
+   stats->save(s);
+   modifiers.save(s);
+   autoAttack.save(s);
+   
+   if(ai) {
+      ai->save(s);
+   }
+}
+
+void Unit::load(SnapshotReader& s) {
+   Object::load(s);
+   stats->load(s);
+   modifiers.load(s);
+   autoAttack.load(s);
+   
+   if(ai) {
+      ai->load(s);
+   }
+}
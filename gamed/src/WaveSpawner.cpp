@@ -0,0 +1,69 @@
+#include "WaveSpawner.h"
+#include "Game.h"
+#include "Map.h"
+#include "Snapshot.h"
+
+static const MinionSpawnPosition spawnPositions[] = {
+   SPAWN_BLUE_TOP,
+   SPAWN_BLUE_BOT,
+   SPAWN_BLUE_MID,
+   SPAWN_RED_TOP,
+   SPAWN_RED_BOT,
+   SPAWN_RED_MID
+};
+
+void WaveSpawner::start() {
+   if(isScheduled() || waveNo > 0) {
+      return;
+   }
+
+   map->getTimers().schedule(this, WAVE_FIRST_DELAY);
+}
+
+uint8 WaveSpawner::getWaveSize() const {
+   return (waveNo % WAVE_CANNON_EVERY == WAVE_CANNON_EVERY-1) ? 7 : 6;
+}
+
+MinionSpawnType WaveSpawner::getNextType() const {
+   if(spawned < 3) {
+      return MINION_TYPE_MELEE;
+   }
+
+   if(getWaveSize() == 7 && spawned == 3) {
+      return MINION_TYPE_CANNON;
+   }
+
+   return MINION_TYPE_CASTER;
+}
+
+void WaveSpawner::onTimer() {
+   MinionSpawnType type = getNextType();
+
+   for(MinionSpawnPosition position : spawnPositions) {
+      Minion* m = new Minion(map, map->getNewNetId(), type, position);
+      map->addObject(m);
+      map->getGame()->notifyMinionSpawned(m);
+      m->getAI()->onSpawn();
+   }
+
+   if(++spawned < getWaveSize()) {
+      map->getTimers().schedule(this, WAVE_SPAWN_INTERVAL);
+      return;
+   }
+
+   map->getTimers().schedule(this, WAVE_INTERVAL - (spawned-1)*WAVE_SPAWN_INTERVAL);
+   spawned = 0;
+   ++waveNo;
+}
+
+void WaveSpawner::save(SnapshotWriter& s) const {
+   s.put(waveNo);
+   s.put(spawned);
+   s.putTimer(*this);
+}
+
+void WaveSpawner::load(SnapshotReader& s) {
+   waveNo = s.get<uint32>();
+   spawned = s.get<uint8>();
+   s.getTimer(*this, map->getTimers());
+}
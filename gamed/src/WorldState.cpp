@@ -0,0 +1,92 @@
+#include "WorldState.h"
+#include "Unit.h"
+
+void WorldFrame::clear() {
+   units.clear();
+   waypoints.clear();
+   statMasks.clear();
+   statValues.clear();
+}
+
+void WorldFrame::capture(Object* o, bool removed) {
+   UnitView v;
+   v.netId = o->getNetId();
+   v.x = o->getX();
+   v.y = o->getY();
+   v.side = o->getSide();
+   v.health = v.maxHealth = 0;
+   v.firstWaypoint = waypoints.size();
+   v.waypointCount = 0;
+   v.flags = removed ? VIEW_REMOVED : 0;
+   v.statMasterMask = 0;
+   v.firstStatMask = statMasks.size();
+   v.firstStatValue = statValues.size();
+
+   if(o->isMovementUpdated()) {
+      const std::vector<MovementVector>& path = o->getWaypoints();
+      waypoints.insert(waypoints.end(), path.begin(), path.end());
+      v.waypointCount = path.size();
+      v.flags |= VIEW_MOVED;
+      o->clearMovementUpdated();
+   }
+
+   Unit* u = dynamic_cast<Unit*>(o);
+   if(u) {
+      Stats& stats = u->getStats();
+      v.flags |= VIEW_UNIT;
+      v.health = stats.getCurrentHealth();
+      v.maxHealth = stats.getMaxHealth();
+      v.statMasterMask = stats.getUpdatedMasterMask();
+
+      for(int i = 0; i < 5; ++i) {
+         if(!(v.statMasterMask & (1 << i))) {
+            continue;
+         }
+
+         uint32 mask = stats.getUpdatedMask(1 << i);
+         statMasks.push_back(mask);
+         for(uint32 fields = mask; fields; fields &= fields-1) {
+            statValues.push_back(stats.getStat(1 << i, fields & -fields));
+         }
+      }
+
+      if(v.statMasterMask) {
+         v.flags |= VIEW_STATS;
+         stats.clearUpdatedStats();
+      }
+   }
+
+   units.push_back(v);
+}
+
+WorldFrame& WorldState::beginFrame(uint64 time) {
+   std::lock_guard<std::mutex> guard(lock);
+
+   // A frame only the pool holds isn't read by anyone anymore
+   writing.reset();
+   for(auto& frame : frames) {
+      if(frame != current && frame.use_count() == 1) {
+         writing = frame;
+         break;
+      }
+   }
+
+   if(!writing) {
+      writing = std::make_shared<WorldFrame>();
+      frames.push_back(writing);
+   }
+
+   writing->clear();
+   writing->time = time;
+   return *writing;
+}
+
+void WorldState::publish() {
+   std::lock_guard<std::mutex> guard(lock);
+   current = writing;
+}
+
+std::shared_ptr<const WorldFrame> WorldState::acquire() {
+   std::lock_guard<std::mutex> guard(lock);
+   return current;
+}
@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "stdafx.h"
 #include "Game.h"
+#include "FlightRecorder.h"
 
 #define SERVER_HOST ENET_HOST_ANY 
 #define SERVER_PORT 5119
@@ -28,12 +29,41 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 int main(int argc, char ** argv) 
 {
 
+	if(argc == 3 && !strcmp(argv[1], "--flight")) {
+		return FlightRecorder::print(argv[2]) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	
+	FlightRecorder::getInstance().installHandlers();
 	Game g;
+	
+	if(argc == 3 && !strcmp(argv[1], "--replay")) {
+		return g.replay(argv[2], SERVER_KEY) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	
+	const char *snapshotFile = 0;
+	uint32 peerCapacity = DEFAULT_PEER_CAPACITY;
+	
+	for(int i = 1; i+1 < argc; i += 2) {
+		if(!strcmp(argv[i], "--restore")) {
+			snapshotFile = argv[i+1];
+		} else if(!strcmp(argv[i], "--peers")) {
+			peerCapacity = atoi(argv[i+1]);
+		}
+	}
+	
+	if(peerCapacity == 0 || peerCapacity > ENET_PROTOCOL_MAXIMUM_PEER_ID) {
+		printf("--peers must be between 1 and %d\n", ENET_PROTOCOL_MAXIMUM_PEER_ID);
+		return EXIT_FAILURE;
+	}
+	
 	ENetAddress address;
 	address.host = SERVER_HOST;
 	address.port = SERVER_PORT;
 
-	g.initialize(&address, SERVER_KEY);
+	if(!g.initialize(&address, SERVER_KEY, snapshotFile, peerCapacity)) {
+		printf("Couldn't initialize the server\n");
+		return EXIT_FAILURE;
+	}
 	g.netLoop();
 	
 }
\ No newline at end of file
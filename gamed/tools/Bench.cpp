@@ -0,0 +1,286 @@
+/*
+IntWars playground server for League of Legends protocol testing
+Copyright (C) 2012  Intline9 <Intline9@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Microbenchmarks of the server's hot paths, to compare two builds.
+ * Usage: intwars_bench [--out <results.json>] [--time <ms per benchmark>] [--filter <name part>]
+ * Each benchmark runs for about the given time, then its nanoseconds and
+ * heap allocations per operation are written as JSON. Run it from the build
+ * directory, the map benchmarks need gamedata.bin.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "Game.h"
+#include "GameData.h"
+#include "Map.h"
+#include "Minion.h"
+#include "Packets.h"
+#include "Projectile.h"
+#include "Stats.h"
+
+using namespace std;
+
+extern vector<MovementVector> readWaypoints(uint8 *buffer, int coordCount);
+
+static atomic<uint64> allocations(0);
+
+void* operator new(size_t size) {
+   allocations.fetch_add(1, memory_order_relaxed);
+   void* p = malloc(size ? size : 1);
+   if(!p) {
+      throw bad_alloc();
+   }
+   return p;
+}
+
+void operator delete(void* p) noexcept {
+   free(p);
+}
+
+/* Results go through here so the compiler can't drop the work */
+static volatile uint64 sink;
+
+struct BenchResult {
+   string name;
+   uint64 iterations;
+   double nsPerOp;
+   double allocsPerOp;
+};
+
+class Bench {
+
+private:
+   vector<BenchResult> results;
+   uint32 timeMs;
+   string filter;
+
+public:
+   Bench(uint32 timeMs, const string& filter) : timeMs(timeMs), filter(filter) { }
+
+   /**
+    * Calls op in batches, doubling them until a batch lasts the wanted time
+    */
+   template<typename F>
+   void run(const string& name, F op) {
+      if(!filter.empty() && name.find(filter) == string::npos) {
+         return;
+      }
+
+      op(); // Warm up caches and pools
+
+      uint64 batch = 1;
+      while(true) {
+         uint64 allocsBefore = allocations.load();
+         chrono::steady_clock::time_point start = chrono::steady_clock::now();
+         for(uint64 i = 0; i < batch; ++i) {
+            op();
+         }
+         double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+         uint64 allocs = allocations.load() - allocsBefore;
+
+         if(ns >= timeMs*1e6 || batch >= (1ULL << 40)) {
+            BenchResult r = { name, batch, ns/batch, (double)allocs/batch };
+            results.push_back(r);
+            fprintf(stderr, "%-32s %12.1f ns/op %8.2f allocs/op\n", name.c_str(), r.nsPerOp, r.allocsPerOp);
+            return;
+         }
+
+         batch *= 2;
+      }
+   }
+
+   bool write(const char* fileName) const {
+      FILE* f = fopen(fileName, "w");
+      if(!f) {
+         return false;
+      }
+
+      fprintf(f, "{\n  \"version\": 1,\n  \"built\": \"%s %s\",\n  \"benchmarks\": [\n", __DATE__, __TIME__);
+      for(size_t i = 0; i < results.size(); ++i) {
+         const BenchResult& r = results[i];
+         fprintf(f, "    { \"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.2f, \"allocs_per_op\": %.3f }%s\n",
+                 r.name.c_str(), (unsigned long long)r.iterations, r.nsPerOp, r.allocsPerOp, i+1 < results.size() ? "," : "");
+      }
+      fprintf(f, "  ]\n}\n");
+      fclose(f);
+      return true;
+   }
+
+};
+
+static void benchBlowfish(Bench& bench) {
+   unsigned char key[16] = { 0x17, 0xB0, 0x2C, 0xE0, 0x88, 0x8A, 0x29, 0x9B, 0x13, 0x2D, 0xB5, 0x4A, 0xCC, 0x8B, 0x1E, 0x1E };
+   BlowFish blowfish(key, sizeof(key));
+   vector<uint8> buffer(PEER_MTU - PEER_MTU%8, 0x5A);
+
+   bench.run("blowfish_encrypt_mtu", [&]() {
+      blowfish.Encrypt(&buffer[0], buffer.size());
+   });
+   bench.run("blowfish_decrypt_mtu", [&]() {
+      blowfish.Decrypt(&buffer[0], buffer.size());
+   });
+   bench.run("blowfish_schedule_cached", [&]() {
+      BlowFish other(key, sizeof(key));
+      sink += other.getKeySize();
+   });
+}
+
+static void benchMovement(Bench& bench) {
+   // 16 absolute coordinates, all the masks cleared
+   const int coordCount = 32;
+   vector<uint8> request((coordCount + 5)/8 + (coordCount/2)*4, 0);
+   for(uint32 i = (coordCount + 5)/8; i + 1 < request.size(); i += 2) {
+      *(short*)&request[i] = (short)i;
+   }
+
+   bench.run("read_waypoints_16", [&]() {
+      vector<MovementVector> waypoints = readWaypoints(&request[0], coordCount);
+      sink += waypoints.size();
+   });
+
+   bench.run("movement_ans_encode_16", [&]() {
+      MovementAns *answer = MovementAns::create(coordCount);
+      answer->nbUpdates = 1;
+      answer->netId = 0x40000019;
+      for(int i = 0; i < coordCount/2; i++) {
+         answer->getVector(i)->x = i;
+         answer->getVector(i)->y = -i;
+      }
+      sink += answer->size();
+      MovementAns::destroy(answer);
+   });
+}
+
+static void benchPackets(Bench& bench) {
+   bench.run("hero_spawn_serialize", [&]() {
+      HeroSpawn spawn(0x40000019, 0, "Test", "Ezreal", 6);
+      sink += spawn.getBuffer().size();
+   });
+
+   uint32 masks[2] = { 0x0000FFFF, 0x000000FF };
+   float values[24];
+   for(int i = 0; i < 24; ++i) {
+      values[i] = i*1.5f;
+   }
+
+   bench.run("update_stats_serialize_24", [&]() {
+      UpdateStats us(0x40000019, MM_Two | MM_Four, masks, values);
+      sink += us.getBuffer().size();
+   });
+}
+
+static void benchStats(Bench& bench) {
+   Stats stats;
+   uint32 i = 0;
+
+   bench.run("stats_set_get", [&]() {
+      stats.setStat(MM_Two, FM2_Armor, (float)++i);
+      sink += (uint64)stats.getArmor();
+      sink += stats.getUpdatedMasterMask();
+   });
+}
+
+/**
+ * A map with count minions spread over the lanes, already walking
+ */
+static Map* createMap(Game* game, uint32 count) {
+   Map* map = new Map(game);
+   for(uint32 i = 0; i < count; ++i) {
+      Minion* m = new Minion(map, map->getNewNetId(), MINION_TYPE_MELEE, (MinionSpawnPosition)(i % 6));
+      map->addObject(m);
+      m->getAI()->onSpawn();
+   }
+   map->update(0);
+   return map;
+}
+
+static void benchMap(Bench& bench, Game* game) {
+   uint32 counts[3] = { 10, 100, 1000 };
+
+   for(uint32 count : counts) {
+      Map* map = createMap(game, count);
+      bench.run("map_update_" + to_string(count), [&]() {
+         map->update(10);
+      });
+      delete map;
+   }
+
+   // One skillshot checked against every object, where they were 100 ms ago
+   Map* map = createMap(game, 1000);
+   for(int i = 0; i < 20; ++i) {
+      map->update(10);
+   }
+
+   Projectile* p = new Projectile(map, map->getNewNetId(), 7000, 7000, 10, 10, new Target(7000, 7000), 0, 2000);
+   p->setRewind(100);
+   vector<Object*> hits;
+   bench.run("projectile_sweep_1000", [&]() {
+      hits.clear();
+      p->sweep(hits);
+      sink += hits.size();
+   });
+   delete p;
+   delete map;
+}
+
+int main(int argc, char** argv) {
+   const char* outFile = "bench.json";
+   uint32 timeMs = 200;
+   string filter;
+
+   for(int i = 1; i+1 < argc; i += 2) {
+      if(!strcmp(argv[i], "--out")) {
+         outFile = argv[i+1];
+      } else if(!strcmp(argv[i], "--time")) {
+         timeMs = atoi(argv[i+1]);
+      } else if(!strcmp(argv[i], "--filter")) {
+         filter = argv[i+1];
+      } else {
+         fprintf(stderr, "Usage: %s [--out <results.json>] [--time <ms per benchmark>] [--filter <name part>]\n", argv[0]);
+         return EXIT_FAILURE;
+      }
+   }
+
+   if(!GameData::getInstance().load(GAMEDATA_FILE)) {
+      fprintf(stderr, "Couldn't load %s, run the benchmarks from the build directory\n", GAMEDATA_FILE);
+      return EXIT_FAILURE;
+   }
+
+   Bench bench(timeMs, filter);
+   Game game;
+
+   benchBlowfish(bench);
+   benchMovement(bench);
+   benchPackets(bench);
+   benchStats(bench);
+   benchMap(bench, &game);
+
+   if(!bench.write(outFile)) {
+      fprintf(stderr, "Couldn't write %s\n", outFile);
+      return EXIT_FAILURE;
+   }
+
+   fprintf(stderr, "Results written to %s\n", outFile);
+   return EXIT_SUCCESS;
+}
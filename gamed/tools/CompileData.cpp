@@ -0,0 +1,353 @@
+/*
+IntWars playground server for League of Legends protocol testing
+Copyright (C) 2012  Intline9 <Intline9@gmail.com>
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Compiles the text game data definitions into the binary file read by the
+ * server. Usage: compiledata <gamedata.txt> <gamedata.bin>
+ */
+
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+#include "GameData.h"
+#include "StatModifiers.h"
+
+using namespace std;
+
+static const char* attributeNames[ATTR_COUNT] = {
+   "attackDamage",
+   "abilityPower",
+   "attackSpeed",
+   "critChance",
+   "armor",
+   "magicArmor",
+   "hp5",
+   "mp5",
+   "range",
+   "cooldownReduction",
+   "maxHealth",
+   "moveSpeed"
+};
+
+static const char* modifierTypeNames[] = { "flat", "percent", "override" };
+
+struct Compiler {
+   vector<ChampionData> champions;
+   vector<SpellData> spells;
+   vector<ItemData> items;
+
+   string fileName;
+   int line;
+   bool failed;
+
+   Compiler(const string& fileName) : fileName(fileName), line(0), failed(false) { }
+
+   void error(const string& message) {
+      fprintf(stderr, "%s:%d: %s\n", fileName.c_str(), line, message.c_str());
+      failed = true;
+   }
+
+   void readFloats(istringstream& values, float* out, int count, const string& key) {
+      int i = 0;
+      while(i < count && values >> out[i]) {
+         ++i;
+      }
+
+      if(i == 0) {
+         error("no value for " + key);
+      }
+
+      // Missing ranks keep the last given value
+      for(; i > 0 && i < count; ++i) {
+         out[i] = out[i-1];
+      }
+   }
+
+   void setName(char* out, uint32* hash, const string& name) {
+      if(name.length() >= DATA_NAME_LENGTH) {
+         error("name too long: " + name);
+         return;
+      }
+
+      strncpy(out, name.c_str(), DATA_NAME_LENGTH);
+      *hash = HashName(name);
+   }
+
+   void parseChampion(ChampionData& c, const string& key, istringstream& values) {
+      if(key == "spells") {
+         string spell;
+         for(int i = 0; i < 4 && values >> spell; ++i) {
+            c.spells[i] = HashName(spell);
+         }
+         return;
+      }
+
+      float* field = 0;
+      if(key == "health") field = &c.health;
+      else if(key == "mana") field = &c.mana;
+      else if(key == "attackDamage") field = &c.attackDamage;
+      else if(key == "range") field = &c.range;
+      else if(key == "moveSpeed") field = &c.moveSpeed;
+      else if(key == "armor") field = &c.armor;
+      else if(key == "magicArmor") field = &c.magicArmor;
+      else if(key == "hp5") field = &c.hp5;
+      else if(key == "mp5") field = &c.mp5;
+
+      if(!field) {
+         error("unknown champion key " + key);
+         return;
+      }
+
+      readFloats(values, field, 1, key);
+   }
+
+   void parseSpell(SpellData& s, const string& key, istringstream& values) {
+      if(key == "id") {
+         string id;
+         values >> id;
+         s.id = strtoul(id.c_str(), 0, 0);
+      } else if(key == "castTime") {
+         readFloats(values, &s.castTime, 1, key);
+      } else if(key == "cooldown") {
+         readFloats(values, s.cooldown, 5, key);
+      } else if(key == "cost") {
+         readFloats(values, s.cost, 5, key);
+      } else if(key == "damage") {
+         readFloats(values, s.damage, 5, key);
+      } else if(key == "projectileSpeed") {
+         readFloats(values, &s.projectileSpeed, 1, key);
+      } else {
+         error("unknown spell key " + key);
+      }
+   }
+
+   void parseItem(ItemData& item, const string& key, istringstream& values) {
+      if(key == "price") {
+         values >> item.price;
+         return;
+      }
+
+      if(key != "modifier") {
+         error("unknown item key " + key);
+         return;
+      }
+
+      if(item.modifierCount >= ITEM_MAX_MODIFIERS) {
+         error("too many modifiers");
+         return;
+      }
+
+      string attribute, type;
+      ItemModifierData& m = item.modifiers[item.modifierCount];
+      values >> attribute >> type >> m.value;
+
+      int a = 0;
+      while(a < ATTR_COUNT && attribute != attributeNames[a]) {
+         ++a;
+      }
+
+      int t = 0;
+      while(t < 3 && type != modifierTypeNames[t]) {
+         ++t;
+      }
+
+      if(a == ATTR_COUNT || t == 3) {
+         error("bad modifier, expected <attribute> <flat|percent|override> <value>");
+         return;
+      }
+
+      m.attribute = a;
+      m.type = t;
+      ++item.modifierCount;
+   }
+
+   bool parse(istream& in) {
+      enum { NONE, CHAMPION, SPELL, ITEM } section = NONE;
+      string text;
+
+      while(getline(in, text)) {
+         ++line;
+
+         size_t comment = text.find('#');
+         if(comment != string::npos) {
+            text.erase(comment);
+         }
+
+         istringstream tokens(text);
+         string first;
+         if(!(tokens >> first)) {
+            continue;
+         }
+
+         if(first[0] == '[') {
+            string name;
+            tokens >> name;
+            if(name.empty() || name[name.length()-1] != ']') {
+               error("expected [<champion|spell|item> <name>]");
+               section = NONE;
+               continue;
+            }
+            name.erase(name.length()-1);
+
+            if(first == "[champion") {
+               champions.push_back(ChampionData());
+               memset(&champions.back(), 0, sizeof(ChampionData));
+               setName(champions.back().name, &champions.back().nameHash, name);
+               section = CHAMPION;
+            } else if(first == "[spell") {
+               spells.push_back(SpellData());
+               memset(&spells.back(), 0, sizeof(SpellData));
+               setName(spells.back().name, &spells.back().nameHash, name);
+               section = SPELL;
+            } else if(first == "[item") {
+               items.push_back(ItemData());
+               memset(&items.back(), 0, sizeof(ItemData));
+               items.back().id = strtoul(name.c_str(), 0, 0);
+               section = ITEM;
+            } else {
+               error("unknown section " + first.substr(1));
+               section = NONE;
+            }
+            continue;
+         }
+
+         string equals;
+         if(!(tokens >> equals) || equals != "=") {
+            error("expected <key> = <values>");
+            continue;
+         }
+
+         switch(section) {
+         case CHAMPION:
+            parseChampion(champions.back(), first, tokens);
+            break;
+         case SPELL:
+            parseSpell(spells.back(), first, tokens);
+            break;
+         case ITEM:
+            parseItem(items.back(), first, tokens);
+            break;
+         default:
+            error("key outside of a section");
+         }
+      }
+
+      return !failed;
+   }
+
+   bool insert(vector<GameDataBucket>& buckets, DataKind kind, uint32 key, uint16 index, const string& name) {
+      uint32 mask = buckets.size()-1;
+      uint32 i = key & mask;
+
+      for(; buckets[i].kind != DATA_NONE; i = (i+1) & mask) {
+         if(buckets[i].kind == kind && buckets[i].key == key) {
+            fprintf(stderr, "%s: duplicate or colliding definition %s\n", fileName.c_str(), name.c_str());
+            return false;
+         }
+      }
+
+      buckets[i].key = key;
+      buckets[i].kind = kind;
+      buckets[i].index = index;
+      return true;
+   }
+
+   bool write(const string& outName) {
+      uint32 entries = champions.size() + spells.size() + items.size();
+      uint32 bucketCount = 1;
+      while(bucketCount < entries*2) {
+         bucketCount <<= 1;
+      }
+
+      vector<GameDataBucket> buckets(bucketCount);
+      memset(&buckets[0], 0, bucketCount*sizeof(GameDataBucket));
+
+      bool ok = true;
+      for(uint32 i = 0; i < champions.size(); ++i) {
+         ok &= insert(buckets, DATA_CHAMPION, champions[i].nameHash, i, champions[i].name);
+      }
+      for(uint32 i = 0; i < spells.size(); ++i) {
+         ok &= insert(buckets, DATA_SPELL, spells[i].nameHash, i, spells[i].name);
+      }
+      for(uint32 i = 0; i < items.size(); ++i) {
+         ostringstream name;
+         name << "item " << items[i].id;
+         ok &= insert(buckets, DATA_ITEM, items[i].id, i, name.str());
+      }
+
+      if(!ok) {
+         return false;
+      }
+
+      GameDataHeader header;
+      memset(&header, 0, sizeof(header));
+      header.magic = GAMEDATA_MAGIC;
+      header.version = GAMEDATA_VERSION;
+      header.bucketCount = bucketCount;
+      header.bucketOffset = sizeof(GameDataHeader);
+      header.championCount = champions.size();
+      header.championOffset = header.bucketOffset + bucketCount*sizeof(GameDataBucket);
+      header.spellCount = spells.size();
+      header.spellOffset = header.championOffset + champions.size()*sizeof(ChampionData);
+      header.itemCount = items.size();
+      header.itemOffset = header.spellOffset + spells.size()*sizeof(SpellData);
+      header.size = header.itemOffset + items.size()*sizeof(ItemData);
+
+      ofstream out(outName.c_str(), ios::binary);
+      out.write((const char*)&header, sizeof(header));
+      out.write((const char*)&buckets[0], bucketCount*sizeof(GameDataBucket));
+      if(!champions.empty()) {
+         out.write((const char*)&champions[0], champions.size()*sizeof(ChampionData));
+      }
+      if(!spells.empty()) {
+         out.write((const char*)&spells[0], spells.size()*sizeof(SpellData));
+      }
+      if(!items.empty()) {
+         out.write((const char*)&items[0], items.size()*sizeof(ItemData));
+      }
+
+      if(!out) {
+         fprintf(stderr, "Couldn't write %s\n", outName.c_str());
+         return false;
+      }
+
+      printf("%s: %u champions, %u spells, %u items, %u bytes\n", outName.c_str(), header.championCount, header.spellCount, header.itemCount, header.size);
+      return true;
+   }
+};
+
+int main(int argc, char** argv) {
+   if(argc != 3) {
+      fprintf(stderr, "Usage: %s <gamedata.txt> <gamedata.bin>\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   ifstream in(argv[1]);
+   if(!in) {
+      fprintf(stderr, "Couldn't open %s\n", argv[1]);
+      return EXIT_FAILURE;
+   }
+
+   Compiler compiler(argv[1]);
+   if(!compiler.parse(in) || !compiler.write(argv[2])) {
+      return EXIT_FAILURE;
+   }
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+/**
+ * Formats shared by the capture tools.
+ * pcapDecrypt --stream writes a record stream: a StreamHeader, then per
+ * message a StreamRecord followed by its decrypted bytes.
+ * captureTool imports streams or text dumps in an indexed store: the same
+ * records, then a time index and an opcode index to answer queries without
+ * reading the whole capture.
+ */
+
+#ifndef _CAPTURE_H
+#define _CAPTURE_H
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(WIN32) || defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#define STREAM_MAGIC 0x50575749          // "IWWP"
+#define STREAM_VERSION 1
+
+#define STORE_MAGIC 0x53435749           // "IWCS"
+#define STORE_VERSION 1
+
+#pragma pack(push, 1)
+struct StreamHeader {
+   unsigned int magic;
+   unsigned short version;
+   unsigned short reserved;
+};
+
+// Followed by the length decrypted bytes of the message
+struct StreamRecord {
+   unsigned int sec, usec;       // Since the first packet of the capture
+   unsigned char srcIp[4], dstIp[4];
+   unsigned short srcPort, dstPort;
+   unsigned char channel;
+   unsigned char fragmented;
+   unsigned int length;
+};
+struct StoreHeader {
+   unsigned int magic;
+   unsigned short version;
+   unsigned short reserved;
+   unsigned long long recordCount;
+   unsigned long long indexOffset;      // TimeIndexEntry[recordCount], then OpcodeIndexEntry[256], then unsigned int[recordCount]
+   unsigned char serverIp[4];           // Endpoint of the most messages, every other one is a client
+};
+
+// Records in capture order
+struct TimeIndexEntry {
+   unsigned long long time;             // Microseconds since the start of the capture
+   unsigned long long offset;           // Of the StreamRecord in the file
+   unsigned int length;
+   unsigned char opcode;                // First byte of the message
+   unsigned char channel;
+   unsigned char toClient;              // Sent by the server
+   unsigned char reserved;
+};
+
+// Range of an opcode's records, in the list of record numbers sorted by opcode then time
+struct OpcodeIndexEntry {
+   unsigned int first;
+   unsigned int count;
+};
+#pragma pack(pop)
+
+struct MappedFile {
+   const unsigned char* data;
+   size_t size;
+#if defined(WIN32) || defined(_WIN32)
+   HANDLE file, mapping;
+#endif
+
+   MappedFile() : data(0), size(0) { }
+
+   bool open(const char* fileName) {
+#if defined(WIN32) || defined(_WIN32)
+      file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+      if(file == INVALID_HANDLE_VALUE)
+         return false;
+      LARGE_INTEGER fileSize;
+      GetFileSizeEx(file, &fileSize);
+      size = (size_t)fileSize.QuadPart;
+      mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+      if(!mapping)
+         return false;
+      data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      return data != 0;
+#else
+      int fd = ::open(fileName, O_RDONLY);
+      if(fd < 0)
+         return false;
+      struct stat st;
+      if(fstat(fd, &st) < 0 || st.st_size == 0) {
+         ::close(fd);
+         return false;
+      }
+      size = st.st_size;
+      void* mapped = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      ::close(fd);
+      if(mapped == MAP_FAILED)
+         return false;
+      madvise(mapped, size, MADV_SEQUENTIAL);
+      data = (const unsigned char*)mapped;
+      return true;
+#endif
+   }
+
+   ~MappedFile() {
+      if(!data)
+         return;
+#if defined(WIN32) || defined(_WIN32)
+      UnmapViewOfFile(data);
+      CloseHandle(mapping);
+      CloseHandle(file);
+#else
+      munmap((void*)data, size);
+#endif
+   }
+};
+
+#endif
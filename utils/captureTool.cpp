@@ -0,0 +1,564 @@
+/**
+ * Indexed capture store, and the queries behind our protocol decisions
+ * Usage : captureTool import <in.iwp|dump.txt> <out.iwc>
+ *         captureTool stats <in.iwc> [filters]
+ *         captureTool extract <in.iwc> <out.iwp> [filters]
+ * Filters : --from <s> --to <s> --opcode <hex> --channel <n> --dir <s2c|c2s>
+ * import reads a pcapDecrypt --stream output or a text dump like the ones
+ * in dumps/, and writes the messages followed by an index of them by time
+ * and by opcode (see capture.h). Queries only read the index, and the
+ * records they extract.
+ * stats prints, per direction, channel and opcode, the messages, bytes,
+ * size histogram and inter-arrival times, the most bytes first.
+ * extract writes the selected messages as a stream, pcapDecrypt --render
+ * prints it and import takes it back.
+ * The opcode is the first byte of a message, batches (0xFF) aren't split.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "capture.h"
+
+using namespace std;
+
+#define STORE_INDEX_ALIGN 8
+#define SIZE_BUCKETS 9              // Up to 8 bytes, 16, ... 1024, then larger
+#define NO_FILTER -1
+
+static unsigned int ipToInt(const unsigned char ip[4]) {
+   return ((unsigned int)ip[0] << 24) | (ip[1] << 16) | (ip[2] << 8) | ip[3];
+}
+
+static void printIp(unsigned int ip) {
+   printf("%u.%u.%u.%u", ip >> 24, (ip >> 16) & 0xFF, (ip >> 8) & 0xFF, ip & 0xFF);
+}
+
+/**
+ * Writes the records as they come, then the index of them
+ */
+class StoreWriter {
+
+private:
+   FILE* out;
+   unsigned long long offset;
+   vector<TimeIndexEntry> entries;
+   vector<pair<unsigned int, unsigned int> > endpoints; // Source and destination of each record
+
+public:
+   StoreWriter(FILE* out) : out(out), offset(0) {
+      StoreHeader header;
+      memset(&header, 0, sizeof(header));
+      write(&header, sizeof(header));
+   }
+
+   void write(const void* data, size_t length) {
+      fwrite(data, 1, length, out);
+      offset += length;
+   }
+
+   void add(const StreamRecord& record, const unsigned char* data) {
+      TimeIndexEntry entry;
+      entry.time = (unsigned long long)record.sec*1000000 + record.usec;
+      entry.offset = offset;
+      entry.length = record.length;
+      entry.opcode = record.length ? data[0] : 0;
+      entry.channel = record.channel;
+      entry.toClient = 0;
+      entry.reserved = 0;
+      entries.push_back(entry);
+      endpoints.push_back(make_pair(ipToInt(record.srcIp), ipToInt(record.dstIp)));
+
+      write(&record, sizeof(record));
+      write(data, record.length);
+   }
+
+   unsigned long long getRecords() const { return entries.size(); }
+
+   bool finish() {
+      // The server is in every message, a client only in its own
+      map<unsigned int, unsigned long long> seen;
+      for(size_t i = 0; i < endpoints.size(); ++i) {
+         ++seen[endpoints[i].first];
+         ++seen[endpoints[i].second];
+      }
+
+      unsigned int server = 0;
+      unsigned long long serverCount = 0;
+      for(map<unsigned int, unsigned long long>::iterator it = seen.begin(); it != seen.end(); ++it) {
+         if(it->second > serverCount) {
+            server = it->first;
+            serverCount = it->second;
+         }
+      }
+
+      for(size_t i = 0; i < entries.size(); ++i)
+         entries[i].toClient = endpoints[i].first == server;
+
+      // Fragmented messages complete after their first fragment, the index is by time anyway
+      stable_sort(entries.begin(), entries.end(), [](const TimeIndexEntry& a, const TimeIndexEntry& b) {
+         return a.time < b.time;
+      });
+
+      OpcodeIndexEntry opcodes[256];
+      memset(opcodes, 0, sizeof(opcodes));
+      for(size_t i = 0; i < entries.size(); ++i)
+         ++opcodes[entries[i].opcode].count;
+      for(int i = 1; i < 256; ++i)
+         opcodes[i].first = opcodes[i-1].first + opcodes[i-1].count;
+
+      vector<unsigned int> byOpcode(entries.size());
+      unsigned int filled[256] = { 0 };
+      for(size_t i = 0; i < entries.size(); ++i) {
+         unsigned char opcode = entries[i].opcode;
+         byOpcode[opcodes[opcode].first + filled[opcode]++] = i;
+      }
+
+      static const unsigned char padding[STORE_INDEX_ALIGN] = { 0 };
+      write(padding, (STORE_INDEX_ALIGN - offset % STORE_INDEX_ALIGN) % STORE_INDEX_ALIGN);
+
+      StoreHeader header;
+      memset(&header, 0, sizeof(header));
+      header.magic = STORE_MAGIC;
+      header.version = STORE_VERSION;
+      header.recordCount = entries.size();
+      header.indexOffset = offset;
+      for(int i = 0; i < 4; ++i)
+         header.serverIp[i] = server >> (24 - 8*i);
+
+      if(!entries.empty()) {
+         write(&entries[0], entries.size()*sizeof(TimeIndexEntry));
+         write(opcodes, sizeof(opcodes));
+         write(&byOpcode[0], byOpcode.size()*sizeof(unsigned int));
+      } else {
+         write(opcodes, sizeof(opcodes));
+      }
+
+      fseek(out, 0, SEEK_SET);
+      fwrite(&header, sizeof(header), 1, out);
+      return !ferror(out);
+   }
+
+};
+
+/**
+ * Reads the records of a pcapDecrypt stream
+ */
+static bool importStream(const MappedFile& in, StoreWriter& writer) {
+   const unsigned char* p = in.data + sizeof(StreamHeader);
+   const unsigned char* end = in.data + in.size;
+
+   while(p + sizeof(StreamRecord) <= end) {
+      StreamRecord record;
+      memcpy(&record, p, sizeof(record));
+      p += sizeof(record);
+      if(record.length > (size_t)(end - p)) {
+         fprintf(stderr, "Stream truncated after %llu messages\n", writer.getRecords());
+         return false;
+      }
+
+      writer.add(record, p);
+      p += record.length;
+   }
+
+   return true;
+}
+
+/**
+ * Reads a text dump: the time, "src -> dst", "Size : n ; Channel : c",
+ * then the hex lines, the escaped line is ignored
+ */
+static bool importText(const MappedFile& in, StoreWriter& writer) {
+   const char* p = (const char*)in.data;
+   const char* end = p + in.size;
+
+   StreamRecord record;
+   vector<unsigned char> data;
+   bool pending = false;
+   unsigned long long mismatched = 0;
+   char line[512];
+
+   while(p < end) {
+      const char* eol = (const char*)memchr(p, '\n', end - p);
+      if(!eol)
+         eol = end;
+      size_t length = min<size_t>(eol - p, sizeof(line) - 1);
+      memcpy(line, p, length);
+      line[length] = 0;
+      if(length && line[length-1] == '\r')
+         line[length-1] = 0;
+      p = eol + 1;
+
+      double time;
+      int consumed = 0;
+      unsigned int ip[8], size, first, last;
+      int channel;
+
+      if(sscanf(line, "%lf%n", &time, &consumed) == 1 && !line[consumed]) {
+         if(pending) {
+            mismatched += data.size() != record.length;
+            record.length = data.size();
+            writer.add(record, data.empty() ? 0 : &data[0]);
+         }
+
+         memset(&record, 0, sizeof(record));
+         record.sec = (unsigned int)time;
+         record.usec = (unsigned int)((time - record.sec)*1000000 + 0.5);
+         if(record.usec >= 1000000) {
+            ++record.sec;
+            record.usec -= 1000000;
+         }
+         data.clear();
+         pending = true;
+      } else if(!pending) {
+         continue;
+      } else if(sscanf(line, "%u.%u.%u.%u -> %u.%u.%u.%u", &ip[0], &ip[1], &ip[2], &ip[3], &ip[4], &ip[5], &ip[6], &ip[7]) == 8) {
+         for(int i = 0; i < 4; ++i) {
+            record.srcIp[i] = ip[i];
+            record.dstIp[i] = ip[4+i];
+         }
+      } else if(sscanf(line, "Size : %u ; Channel : %d", &size, &channel) == 2) {
+         record.length = size;
+         record.channel = channel;
+      } else if(sscanf(line, "%u-%u%n", &first, &last, &consumed) == 2 && last >= first && last - first < 16) {
+         const char* hex = line + consumed;
+         for(unsigned int i = 0; i <= last - first; ++i) {
+            unsigned int byte;
+            if(sscanf(hex, " %2x", &byte) != 1)
+               break;
+            data.push_back(byte);
+            hex += 3;
+         }
+      }
+   }
+
+   if(pending) {
+      mismatched += data.size() != record.length;
+      record.length = data.size();
+      writer.add(record, data.empty() ? 0 : &data[0]);
+   }
+
+   if(mismatched)
+      fprintf(stderr, "%llu messages didn't have their announced size\n", mismatched);
+   return true;
+}
+
+static int importMain(int argc, char **argv) {
+   if(argc < 4) {
+      fprintf(stderr, "Usage: %s import <in.iwp|dump.txt> <out.iwc>\n", argv[0]);
+      return 1;
+   }
+
+   MappedFile in;
+   if(!in.open(argv[2])) {
+      fprintf(stderr, "Couldn't open %s\n", argv[2]);
+      return 2;
+   }
+
+   FILE* out = fopen(argv[3], "wb");
+   if(!out) {
+      fprintf(stderr, "Couldn't create %s\n", argv[3]);
+      return 2;
+   }
+
+   StreamHeader header;
+   bool isStream = in.size >= sizeof(header) && (memcpy(&header, in.data, sizeof(header)), header.magic == STREAM_MAGIC);
+   if(isStream && header.version != STREAM_VERSION) {
+      fprintf(stderr, "%s is a stream of version %d, expected %d\n", argv[2], header.version, STREAM_VERSION);
+      fclose(out);
+      return 2;
+   }
+
+   StoreWriter writer(out);
+   bool ok = isStream ? importStream(in, writer) : importText(in, writer);
+   ok = writer.finish() && ok;
+   fclose(out);
+
+   if(!ok) {
+      fprintf(stderr, "Couldn't write %s\n", argv[3]);
+      return 2;
+   }
+
+   fprintf(stderr, "%llu messages indexed in %s\n", writer.getRecords(), argv[3]);
+   return 0;
+}
+
+struct Filter {
+   unsigned long long from, to;  // Microseconds
+   int opcode, channel, toClient;
+
+   Filter() : from(0), to(~0ULL), opcode(NO_FILTER), channel(NO_FILTER), toClient(NO_FILTER) { }
+
+   /**
+    * Reads the filters from the options, from first on
+    */
+   bool parse(int argc, char **argv, int first) {
+      for(int i = first; i < argc; i += 2) {
+         if(i+1 >= argc)
+            return false;
+         const char* value = argv[i+1];
+
+         if(!strcmp(argv[i], "--from"))
+            from = (unsigned long long)(atof(value)*1000000);
+         else if(!strcmp(argv[i], "--to"))
+            to = (unsigned long long)(atof(value)*1000000);
+         else if(!strcmp(argv[i], "--opcode"))
+            opcode = strtol(value, 0, 16) & 0xFF;
+         else if(!strcmp(argv[i], "--channel"))
+            channel = atoi(value) & 0xFF;
+         else if(!strcmp(argv[i], "--dir") && (!strcmp(value, "s2c") || !strcmp(value, "c2s")))
+            toClient = !strcmp(value, "s2c");
+         else
+            return false;
+      }
+      return true;
+   }
+};
+
+/**
+ * Read only view of an indexed store
+ */
+class Store {
+
+private:
+   MappedFile file;
+   StoreHeader header;
+   const TimeIndexEntry* entries;
+   const OpcodeIndexEntry* opcodes;
+   const unsigned int* byOpcode;
+
+public:
+   Store() : entries(0), opcodes(0), byOpcode(0) { }
+
+   bool open(const char* fileName) {
+      if(!file.open(fileName) || file.size < sizeof(header)) {
+         fprintf(stderr, "Couldn't open %s\n", fileName);
+         return false;
+      }
+
+      memcpy(&header, file.data, sizeof(header));
+      if(header.magic != STORE_MAGIC || header.version != STORE_VERSION) {
+         fprintf(stderr, "%s isn't an indexed capture of version %d\n", fileName, STORE_VERSION);
+         return false;
+      }
+
+      unsigned long long indexSize = header.recordCount*(sizeof(TimeIndexEntry) + sizeof(unsigned int)) + 256*sizeof(OpcodeIndexEntry);
+      if(header.indexOffset % STORE_INDEX_ALIGN || header.indexOffset > file.size || indexSize > file.size - header.indexOffset) {
+         fprintf(stderr, "%s is truncated\n", fileName);
+         return false;
+      }
+
+      entries = (const TimeIndexEntry*)(file.data + header.indexOffset);
+      opcodes = (const OpcodeIndexEntry*)(entries + header.recordCount);
+      byOpcode = (const unsigned int*)(opcodes + 256);
+      return true;
+   }
+
+   const StoreHeader& getHeader() const { return header; }
+
+   /**
+    * Calls f for every entry the filter selects, by time
+    */
+   template<typename F>
+   void select(const Filter& filter, F f) const {
+      auto selected = [&](const TimeIndexEntry& e) {
+         return (filter.channel == NO_FILTER || e.channel == filter.channel) &&
+                (filter.toClient == NO_FILTER || e.toClient == filter.toClient);
+      };
+
+      if(filter.opcode != NO_FILTER) {
+         const unsigned int* first = byOpcode + opcodes[filter.opcode].first;
+         const unsigned int* last = first + opcodes[filter.opcode].count;
+         first = lower_bound(first, last, filter.from, [&](unsigned int i, unsigned long long time) {
+            return entries[i].time < time;
+         });
+         for(; first < last && entries[*first].time <= filter.to; ++first) {
+            if(selected(entries[*first]))
+               f(entries[*first]);
+         }
+         return;
+      }
+
+      const TimeIndexEntry* first = lower_bound(entries, entries + header.recordCount, filter.from, [](const TimeIndexEntry& e, unsigned long long time) {
+         return e.time < time;
+      });
+      for(const TimeIndexEntry* last = entries + header.recordCount; first < last && first->time <= filter.to; ++first) {
+         if(selected(*first))
+            f(*first);
+      }
+   }
+
+   /**
+    * The record of an entry, followed by its bytes, or 0 if it's out of the file
+    */
+   const unsigned char* getRecord(const TimeIndexEntry& e) const {
+      if(e.offset > header.indexOffset || sizeof(StreamRecord) + e.length > header.indexOffset - e.offset)
+         return 0;
+      return file.data + e.offset;
+   }
+
+};
+
+struct OpcodeStats {
+   unsigned long long count, bytes;
+   unsigned int minSize, maxSize;
+   unsigned long long sizes[SIZE_BUCKETS];
+   unsigned long long lastTime;
+   vector<unsigned int> gaps;   // Microseconds between two messages
+
+   OpcodeStats() : count(0), bytes(0), minSize(~0U), maxSize(0), lastTime(0) {
+      memset(sizes, 0, sizeof(sizes));
+   }
+};
+
+static int sizeBucket(unsigned int size) {
+   int bucket = 0;
+   while(bucket < SIZE_BUCKETS-1 && size > (8U << bucket))
+      ++bucket;
+   return bucket;
+}
+
+static double percentileMs(vector<unsigned int>& gaps, double percentile) {
+   if(gaps.empty())
+      return 0;
+   size_t i = min(gaps.size()-1, (size_t)(percentile*gaps.size()));
+   nth_element(gaps.begin(), gaps.begin() + i, gaps.end());
+   return gaps[i]/1000.0;
+}
+
+static int statsMain(int argc, char **argv) {
+   Filter filter;
+   if(argc < 3 || !filter.parse(argc, argv, 3)) {
+      fprintf(stderr, "Usage: %s stats <in.iwc> [--from <s>] [--to <s>] [--opcode <hex>] [--channel <n>] [--dir <s2c|c2s>]\n", argv[0]);
+      return 1;
+   }
+
+   Store store;
+   if(!store.open(argv[2]))
+      return 2;
+
+   // By direction, channel then opcode
+   map<unsigned int, OpcodeStats> groups;
+   unsigned long long directionBytes[2] = { 0, 0 }, directionCount[2] = { 0, 0 };
+   unsigned long long firstTime = ~0ULL, lastTime = 0;
+
+   store.select(filter, [&](const TimeIndexEntry& e) {
+      OpcodeStats& s = groups[(e.toClient << 16) | (e.channel << 8) | e.opcode];
+      if(s.count)
+         s.gaps.push_back((unsigned int)min<unsigned long long>(e.time - s.lastTime, ~0U));
+      s.lastTime = e.time;
+      ++s.count;
+      s.bytes += e.length;
+      s.minSize = min(s.minSize, e.length);
+      s.maxSize = max(s.maxSize, e.length);
+      ++s.sizes[sizeBucket(e.length)];
+
+      ++directionCount[e.toClient];
+      directionBytes[e.toClient] += e.length;
+      firstTime = min(firstTime, e.time);
+      lastTime = max(lastTime, e.time);
+   });
+
+   if(groups.empty()) {
+      printf("No message selected\n");
+      return 0;
+   }
+
+   double seconds = max((lastTime - firstTime)/1000000.0, 0.001);
+   printf("Server ");
+   printIp(ipToInt(store.getHeader().serverIp));
+   printf(", %.3f s to %.3f s\n", firstTime/1000000.0, lastTime/1000000.0);
+
+   for(int toClient = 1; toClient >= 0; --toClient) {
+      if(!directionCount[toClient])
+         continue;
+
+      printf("\n%s: %llu messages, %llu bytes, %.2f kB/s\n", toClient ? "Server to client" : "Client to server",
+             directionCount[toClient], directionBytes[toClient], directionBytes[toClient]/seconds/1000);
+
+      vector<pair<unsigned long long, unsigned int> > sorted;
+      for(map<unsigned int, OpcodeStats>::iterator it = groups.begin(); it != groups.end(); ++it) {
+         if((int)(it->first >> 16) == toClient)
+            sorted.push_back(make_pair(it->second.bytes, it->first));
+      }
+      sort(sorted.rbegin(), sorted.rend());
+
+      printf("ch op    count     bytes  share   avg   min   max  gap p50 ms  gap p99 ms  sizes <=8/16/32/64/128/256/512/1024/more\n");
+      for(size_t i = 0; i < sorted.size(); ++i) {
+         OpcodeStats& s = groups[sorted[i].second];
+         printf("%2d %02x %8llu %9llu %5.1f%% %5llu %5u %5u %11.2f %11.2f  ", (sorted[i].second >> 8) & 0xFF, sorted[i].second & 0xFF,
+                s.count, s.bytes, 100.0*s.bytes/max(directionBytes[toClient], 1ULL), s.bytes/s.count, s.minSize, s.maxSize,
+                percentileMs(s.gaps, 0.5), percentileMs(s.gaps, 0.99));
+         for(int b = 0; b < SIZE_BUCKETS; ++b)
+            printf("%s%llu", b ? "/" : "", s.sizes[b]);
+         printf("\n");
+      }
+   }
+
+   return 0;
+}
+
+static int extractMain(int argc, char **argv) {
+   Filter filter;
+   if(argc < 4 || !filter.parse(argc, argv, 4)) {
+      fprintf(stderr, "Usage: %s extract <in.iwc> <out.iwp> [--from <s>] [--to <s>] [--opcode <hex>] [--channel <n>] [--dir <s2c|c2s>]\n", argv[0]);
+      return 1;
+   }
+
+   Store store;
+   if(!store.open(argv[2]))
+      return 2;
+
+   FILE* out = fopen(argv[3], "wb");
+   if(!out) {
+      fprintf(stderr, "Couldn't create %s\n", argv[3]);
+      return 2;
+   }
+
+   StreamHeader header;
+   header.magic = STREAM_MAGIC;
+   header.version = STREAM_VERSION;
+   header.reserved = 0;
+   fwrite(&header, sizeof(header), 1, out);
+
+   unsigned long long count = 0, bad = 0;
+   store.select(filter, [&](const TimeIndexEntry& e) {
+      const unsigned char* record = store.getRecord(e);
+      if(!record) {
+         ++bad;
+         return;
+      }
+      fwrite(record, 1, sizeof(StreamRecord) + e.length, out);
+      ++count;
+   });
+
+   bool ok = !ferror(out);
+   fclose(out);
+   if(!ok) {
+      fprintf(stderr, "Couldn't write %s\n", argv[3]);
+      return 2;
+   }
+
+   fprintf(stderr, "%llu messages extracted to %s%s\n", count, argv[3], bad ? ", some index entries were out of the file" : "");
+   return 0;
+}
+
+int main(int argc, char **argv) {
+   if(argc >= 2 && !strcmp(argv[1], "import"))
+      return importMain(argc, argv);
+   if(argc >= 2 && !strcmp(argv[1], "stats"))
+      return statsMain(argc, argv);
+   if(argc >= 2 && !strcmp(argv[1], "extract"))
+      return extractMain(argc, argv);
+
+   fprintf(stderr, "Usage: %s import <in.iwp|dump.txt> <out.iwc>\n"
+                   "       %s stats <in.iwc> [filters]\n"
+                   "       %s extract <in.iwc> <out.iwp> [filters]\n"
+                   "Filters: --from <s> --to <s> --opcode <hex> --channel <n> --dir <s2c|c2s>\n", argv[0], argv[0], argv[0]);
+   return 1;
+}
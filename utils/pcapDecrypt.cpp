@@ -3,6 +3,12 @@
  * Decrypt and dump the packets in plaintext
  * Support enet overhead and fragments
  * Usage : pcapDecrypt <pcapFile> [b64key]
+ *         pcapDecrypt --stream <pcapFile> <out.iwp> [b64key] [--threads n]
+ *         pcapDecrypt --render <in.iwp>
+ * The stream mode maps the whole capture in memory, reassembles fragments
+ * per stream and decrypts on every core, then writes compact binary records
+ * instead of text. --render prints such a file like the text dump.
+ * It reads classic pcap files only, pcapng needs the text dump.
  * @author Elyotna
  * @date 18/07/2014
  */
@@ -21,8 +27,14 @@
 #endif
 #include <string.h>
 
+#include <algorithm>
+#include <map>
+#include <thread>
+#include <vector>
+
 #include "blowfish.h"
 #include "base64.h"
+#include "capture.h"
 
 //defines for the packet type code in an ETHERNET header
 #define ETHER_TYPE_IP (0x0800)
@@ -32,6 +44,20 @@
 //#define B64_KEY "17BLOhi6KZsTtldTsizvHg=="
 #define PACKET_FILE "packets.txt"
 
+#define STREAM_BATCH_MESSAGES 65536      // Messages decrypted together, then written
+#define STREAM_MAX_REASSEMBLY (16 << 20) // Larger fragmented messages are dropped
+
+#define LINKTYPE_ETHERNET 1
+#define LINKTYPE_RAW 101
+#define LINKTYPE_LINUX_SLL 113
+
+// ENet command numbers and sizes, as in dep/include/enet/protocol.h
+#define ENET_SEND_RELIABLE 6
+#define ENET_SEND_UNRELIABLE 7
+#define ENET_SEND_FRAGMENT 8
+#define ENET_SEND_UNSEQUENCED 9
+static const unsigned int enetCommandSizes[12] = { 0, 8, 40, 36, 8, 4, 6, 8, 24, 8, 12, 16 };
+
 #define min(a, b)       ((a) < (b) ? (a) : (b))
 
 using namespace std;
@@ -78,9 +104,376 @@ void printPacket(unsigned char* buffer, unsigned int size) {
    puts("\n");
 }
 
+static unsigned short readBe16(const unsigned char* p) {
+   return (p[0] << 8) | p[1];
+}
+
+static unsigned int readBe32(const unsigned char* p) {
+   return ((unsigned int)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+// A message still missing fragments
+struct Reassembly {
+   vector<unsigned char> data;
+   vector<unsigned char> received;
+   unsigned int missing;
+};
+
+struct StreamMessage {
+   StreamRecord record;
+   const unsigned char* data;    // In the capture, or in the batch's reassembled messages
+};
+
+/**
+ * Splits a capture into its ENet messages, decrypts them on several threads
+ * and writes them in capture order
+ */
+class StreamDecrypter {
+
+private:
+   BlowFish& blowfish;
+   FILE* out;
+   unsigned int threadCount;
+   unsigned int startSec, startUsec;
+   bool started;
+   bool swapped, nanoseconds;
+   unsigned int linkType;
+
+   // Fragments by stream, channel and start sequence number
+   map<pair<unsigned long long, unsigned long long>, Reassembly> pending;
+
+   vector<StreamMessage> batch;
+   vector<vector<unsigned char> > reassembled;  // Complete fragmented messages of the batch
+   vector<unsigned char> output;
+
+   unsigned long long messages, fragmentsDropped;
+
+   unsigned int read32(const unsigned char* p) const {
+      unsigned int v;
+      memcpy(&v, p, 4);
+      return swapped ? ((v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24)) : v;
+   }
+
+   void addMessage(const StreamRecord& record, const unsigned char* data) {
+      StreamMessage message;
+      message.record = record;
+      message.data = data;
+      batch.push_back(message);
+
+      if(batch.size() >= STREAM_BATCH_MESSAGES)
+         flush();
+   }
+
+   void addFragment(StreamRecord record, const unsigned char* command, const unsigned char* data, unsigned int length) {
+      unsigned int count = readBe32(command+8), number = readBe32(command+12);
+      unsigned int total = readBe32(command+16), offset = readBe32(command+20);
+
+      unsigned long long stream = ((unsigned long long)readBe32(record.srcIp) << 32) | readBe32(record.dstIp);
+      unsigned long long id = ((unsigned long long)record.srcPort << 48) | ((unsigned long long)record.dstPort << 32) | (record.channel << 16) | readBe16(command+4);
+      pair<unsigned long long, unsigned long long> key(stream, id);
+
+      if(!count || number >= count || total > STREAM_MAX_REASSEMBLY || offset > total || length > total-offset) {
+         ++fragmentsDropped;
+         return;
+      }
+
+      map<pair<unsigned long long, unsigned long long>, Reassembly>::iterator it = pending.find(key);
+      if(it == pending.end()) {
+         Reassembly& r = pending[key];
+         r.data.resize(total);
+         r.received.resize(count);
+         r.missing = count;
+         it = pending.find(key);
+      }
+
+      Reassembly& r = it->second;
+      if(r.data.size() != total || r.received.size() != count) {
+         ++fragmentsDropped;
+         return;
+      }
+      if(r.received[number])
+         return; // Retransmitted
+
+      r.received[number] = 1;
+      memcpy(&r.data[offset], data, length);
+      if(--r.missing)
+         return;
+
+      reassembled.push_back(vector<unsigned char>());
+      reassembled.back().swap(r.data);
+      pending.erase(it);
+
+      record.fragmented = 1;
+      record.length = total;
+      addMessage(record, reassembled.back().empty() ? 0 : &reassembled.back()[0]);
+   }
+
+   void parseEnet(StreamRecord record, const unsigned char* p, unsigned int length) {
+      if(length < 2)
+         return;
+
+      const unsigned char* end = p + length;
+      p += (p[1] & 0x80) ? 4 : 2; // Sent time
+
+      while(p + 4 <= end) {
+         unsigned int command = p[0] & 0x0F;
+         if(command == 0 || command >= 12 || p + enetCommandSizes[command] > end)
+            return;
+
+         unsigned int dataLength = 0;
+         if(command == ENET_SEND_RELIABLE)
+            dataLength = readBe16(p+4);
+         else if(command == ENET_SEND_UNRELIABLE || command == ENET_SEND_UNSEQUENCED || command == ENET_SEND_FRAGMENT)
+            dataLength = readBe16(p+6);
+
+         const unsigned char* data = p + enetCommandSizes[command];
+         if(data + dataLength > end)
+            return;
+
+         record.channel = p[1];
+         if(command == ENET_SEND_FRAGMENT) {
+            addFragment(record, p, data, dataLength);
+         } else if(dataLength) {
+            record.length = dataLength;
+            addMessage(record, data);
+         }
+
+         p = data + dataLength;
+      }
+   }
+
+   void parseFrame(const unsigned char* frame, unsigned int length, unsigned int sec, unsigned int usec) {
+      const unsigned char* end = frame + length;
+      unsigned int etherType = ETHER_TYPE_IP;
+
+      if(linkType == LINKTYPE_ETHERNET) {
+         if(length < 14)
+            return;
+         etherType = readBe16(frame+12);
+         frame += 14;
+         if(etherType == ETHER_TYPE_8021Q && frame + 4 <= end) {
+            etherType = readBe16(frame+2);
+            frame += 4;
+         }
+      } else if(linkType == LINKTYPE_LINUX_SLL) {
+         if(length < 16)
+            return;
+         etherType = readBe16(frame+14);
+         frame += 16;
+      }
+
+      if(etherType != ETHER_TYPE_IP || frame + 20 > end || (frame[0] >> 4) != 4 || frame[9] != IPPROTO_UDP)
+         return;
+
+      unsigned int ipHeader = (frame[0] & 0x0F) * 4;
+      const unsigned char* udp = frame + ipHeader;
+      if(udp + 8 > end)
+         return;
+
+      unsigned int udpLength = readBe16(udp+4);
+      if(udpLength < 8 || udp + udpLength > end)
+         return;
+
+      if(!started) {
+         startSec = sec;
+         startUsec = usec;
+         started = true;
+      }
+
+      StreamRecord record;
+      memset(&record, 0, sizeof(record));
+      long long elapsed = ((long long)sec - startSec) * 1000000 + usec - startUsec;
+      record.sec = (unsigned int)(elapsed / 1000000);
+      record.usec = (unsigned int)(elapsed % 1000000);
+      memcpy(record.srcIp, frame+12, 4);
+      memcpy(record.dstIp, frame+16, 4);
+      record.srcPort = readBe16(udp);
+      record.dstPort = readBe16(udp+2);
+
+      parseEnet(record, udp+8, udpLength-8);
+   }
+
+public:
+   StreamDecrypter(BlowFish& blowfish, FILE* out, unsigned int threadCount) : blowfish(blowfish), out(out), threadCount(threadCount), startSec(0), startUsec(0), started(false), swapped(false), nanoseconds(false), linkType(0), messages(0), fragmentsDropped(0) { }
+
+   bool parse(const unsigned char* data, size_t size) {
+      if(size < 24)
+         return false;
+
+      unsigned int magic;
+      memcpy(&magic, data, 4);
+      if(magic == 0xa1b2c3d4 || magic == 0xa1b23c4d) {
+         swapped = false;
+      } else if(magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1) {
+         swapped = true;
+      } else {
+         fprintf(stderr, "Not a classic pcap file, use the text dump for pcapng\n");
+         return false;
+      }
+      nanoseconds = read32(data) == 0xa1b23c4d;
+      linkType = read32(data+20) & 0xFFFF;
+
+      if(linkType != LINKTYPE_ETHERNET && linkType != LINKTYPE_RAW && linkType != LINKTYPE_LINUX_SLL) {
+         fprintf(stderr, "Unsupported link type %u\n", linkType);
+         return false;
+      }
+
+      StreamHeader header = { STREAM_MAGIC, STREAM_VERSION, 0 };
+      fwrite(&header, sizeof(header), 1, out);
+
+      const unsigned char* p = data + 24;
+      const unsigned char* end = data + size;
+      while(p + 16 <= end) {
+         unsigned int sec = read32(p), usec = read32(p+4), length = read32(p+8);
+         if(length > (size_t)(end - p - 16))
+            break; // Truncated capture
+         if(nanoseconds)
+            usec /= 1000;
+
+         parseFrame(p+16, length, sec, usec);
+         p += 16 + length;
+      }
+
+      flush();
+      return true;
+   }
+
+   /**
+    * Decrypts the batch in place in the output buffer, each thread taking a
+    * range of messages, and writes it
+    */
+   void flush() {
+      if(batch.empty())
+         return;
+
+      vector<size_t> offsets(batch.size()+1, 0);
+      for(size_t i = 0; i < batch.size(); ++i)
+         offsets[i+1] = offsets[i] + sizeof(StreamRecord) + batch[i].record.length;
+      output.resize(offsets.back());
+
+      vector<thread> threads;
+      size_t chunk = (batch.size() + threadCount - 1) / threadCount;
+      for(size_t first = 0; first < batch.size(); first += chunk) {
+         size_t last = min(first + chunk, batch.size());
+         threads.push_back(thread([this, &offsets, first, last]() {
+            for(size_t i = first; i < last; ++i) {
+               unsigned char* dest = &output[offsets[i]];
+               const StreamMessage& message = batch[i];
+               memcpy(dest, &message.record, sizeof(StreamRecord));
+               memcpy(dest + sizeof(StreamRecord), message.data, message.record.length);
+               blowfish.Decrypt(dest + sizeof(StreamRecord), message.record.length);
+            }
+         }));
+      }
+      for(size_t i = 0; i < threads.size(); ++i)
+         threads[i].join();
+
+      fwrite(&output[0], 1, output.size(), out);
+      messages += batch.size();
+      batch.clear();
+      reassembled.clear();
+   }
+
+   unsigned long long getMessages() const { return messages; }
+   unsigned long long getIncomplete() const { return pending.size(); }
+   unsigned long long getFragmentsDropped() const { return fragmentsDropped; }
+};
+
+static int streamMain(int argc, char **argv) {
+   const char* key = B64_KEY;
+   unsigned int threadCount = max(1u, thread::hardware_concurrency());
+   if(argc < 4) {
+      fprintf(stderr, "Usage: %s --stream <pcapFile> <out.iwp> [b64key] [--threads n]\n", argv[0]);
+      return 1;
+   }
+
+   for(int i = 4; i < argc; ++i) {
+      if(!strcmp(argv[i], "--threads") && i+1 < argc)
+         threadCount = max(1, atoi(argv[++i]));
+      else
+         key = argv[i];
+   }
+
+   string decryptedKey = base64_decode(key);
+   BlowFish b((unsigned char*)decryptedKey.c_str(), (size_t)decryptedKey.length());
+
+   MappedFile capture;
+   if(!capture.open(argv[2])) {
+      fprintf(stderr, "Couldn't map pcap file %s\n", argv[2]);
+      return 2;
+   }
+
+   FILE* out = fopen(argv[3], "wb");
+   if(!out) {
+      fprintf(stderr, "Couldn't create %s\n", argv[3]);
+      return 2;
+   }
+
+   StreamDecrypter decrypter(b, out, threadCount);
+   bool ok = decrypter.parse(capture.data, capture.size);
+   fclose(out);
+
+   if(!ok)
+      return 2;
+
+   fprintf(stderr, "%llu messages written to %s, %llu fragmented messages incomplete, %llu bad fragments\n",
+           decrypter.getMessages(), argv[3], decrypter.getIncomplete(), decrypter.getFragmentsDropped());
+   return 0;
+}
+
+/**
+ * Prints a record stream like the text dump
+ */
+static int renderMain(int argc, char **argv) {
+   if(argc < 3) {
+      fprintf(stderr, "Usage: %s --render <in.iwp>\n", argv[0]);
+      return 1;
+   }
+
+   MappedFile stream;
+   if(!stream.open(argv[2])) {
+      fprintf(stderr, "Couldn't open %s\n", argv[2]);
+      return 2;
+   }
+
+   StreamHeader header;
+   if(stream.size < sizeof(header) || (memcpy(&header, stream.data, sizeof(header)), header.magic != STREAM_MAGIC || header.version != STREAM_VERSION)) {
+      fprintf(stderr, "%s isn't a decrypted stream\n", argv[2]);
+      return 2;
+   }
+
+   const unsigned char* p = stream.data + sizeof(header);
+   const unsigned char* end = stream.data + stream.size;
+   vector<unsigned char> data;
+
+   while(p + sizeof(StreamRecord) <= end) {
+      StreamRecord record;
+      memcpy(&record, p, sizeof(record));
+      p += sizeof(record);
+      if(record.length > (size_t)(end - p))
+         break;
+
+      data.assign(p, p + record.length);
+      p += record.length;
+
+      printf("%u.%06u\n", record.sec, record.usec);
+      printf("%d.%d.%d.%d -> %d.%d.%d.%d\n", record.srcIp[0], record.srcIp[1], record.srcIp[2], record.srcIp[3], record.dstIp[0], record.dstIp[1], record.dstIp[2], record.dstIp[3]);
+      printf("Size : %d ; Channel : %d\n", record.length, (char)record.channel);
+      if(!data.empty())
+         printPacket(&data[0], data.size());
+   }
+
+   return 0;
+}
+
 //------------------------------------------------------------------- 
 int main(int argc, char **argv) 
 { 
+  if (argc >= 2 && !strcmp(argv[1], "--stream"))
+    return streamMain(argc, argv);
+  if (argc >= 2 && !strcmp(argv[1], "--render"))
+    return renderMain(argc, argv);
+
  
   //temporary packet buffers 
   struct pcap_pkthdr header; // The header that pcap gives us 